@@ -40,6 +40,7 @@
 #include "driverlib/interrupt.h"
 #include "utils/uartstdio.h"
 #include "EnablePA25_PB23_PD7_PF0.h"
+#include "GameContext.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define clrScrn() 	printf("\x1b[2J")
@@ -57,9 +58,9 @@ void InitAdafruitAudioPortLines(void);
 void pulseLow(uint8_t);
 
 /*---------------------------- Module Variables ---------------------------*/
-// with the introduction of Gen2, we need a module level Priority variable
-static uint8_t MyPriority;
-uint8_t track = 0;
+// the priority and the track being played are kept in AudioContext_t
+// (see GameContext.h)
+#define Ctx (pGame->Audio)
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -82,13 +83,13 @@ bool InitAdafruitAudioService ( uint8_t Priority )
 {
   ES_Event ThisEvent;
 
-  MyPriority = Priority;
+  Ctx.MyPriority = Priority;
 	
   InitAdafruitAudioPortLines();
 	
   // post the initial transition event
   ThisEvent.EventType = ES_INIT;
-  if (ES_PostToService( MyPriority, ThisEvent) == true)
+  if (ES_PostToService( Ctx.MyPriority, ThisEvent) == true)
   {
       return true;
   }else
@@ -114,7 +115,7 @@ bool InitAdafruitAudioService ( uint8_t Priority )
 ****************************************************************************/
 bool PostAdafruitAudioService( ES_Event ThisEvent )
 {
-  return ES_PostToService( MyPriority, ThisEvent);
+  return ES_PostToService( Ctx.MyPriority, ThisEvent);
 }
 
 /****************************************************************************
@@ -149,7 +150,7 @@ ES_Event RunAdafruitAudioService( ES_Event ThisEvent )
 	// set track line back to high to complete LowPulse
 	if((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == AUDIO_TIMER))
 	{
-		switch(track)
+		switch(Ctx.track)
 		{
 			case 1:
 				HWREG(GPIO_PORTF_BASE+(GPIO_O_DATA + ALL_BITS)) |= AUDIO_TRACK01;
@@ -173,21 +174,21 @@ ES_Event RunAdafruitAudioService( ES_Event ThisEvent )
 		{
 			case 1: //track 01
 				pulseLow(1);
-				track = 1;
+				Ctx.track = 1;
 			break;
 		
 			case 2: //track 02
 				pulseLow(2);
-				track = 2;
+				Ctx.track = 2;
 			break;
 			
 			case 3: //track 03
 				pulseLow(3);
-				track = 3;
+				Ctx.track = 3;
 			break;
 		
 			default:
-				track = 0;
+				Ctx.track = 0;
 			break;
 	}
 }
@@ -35,35 +35,26 @@
 #include "SlotDetector.h"
 #include "ArmedLine.h"
 #include "AdafruitAudioService.h"
+#include "LEDAnimation.h"
+#include "GameContext.h"
 
 /*----------------------------- Module Defines ----------------------------*/
-// low output voltage turns on the LED
-#define ON 0
-#define OFF 1
-
-// LED number corresponding to tower layer and pot
-#define Tier1 2
-#define Tier2 0
-#define Tier3 7
-#define Tier4 1
-#define Tier5 4
-#define Tier6 5
-#define pot 3
+// the tiers VictoryAnimation lights once the pot is dialed
+#define DIALED_TIERS (LED_TIER4 | LED_TIER5 | LED_TIER6)
+
+// this module's part of the running station's context
+#define Ctx (pGame->DisarmFSM)
 
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this machine.They should be functions
    relevant to the behavior of this state machine
 */
+void completeDisarm(void);
+void postAnimation(LEDAnimation_t Animation);
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well.
-// type of state variable should match htat of enum in header file
-static DisarmState_t CurrentState;
-static uint16_t startTime;
-static uint16_t endTime;
-
-// with the introduction of Gen2, we need a module level Priority var as well
-static uint8_t MyPriority;
+// the state variable, the priority and the rest of this module's variables
+// are kept in DisarmFSMContext_t (see GameContext.h)
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -97,10 +88,10 @@ bool InitDisarmFSM ( uint8_t Priority )
 	InitAdafruitAudioPortLines();	//initialize audio 
 	initArmedLine();
 	
-  MyPriority = Priority;
-  CurrentState = Armed;
+  Ctx.MyPriority = Priority;
+  Ctx.CurrentState = Armed;
   ThisEvent.EventType = ES_INIT;
-  if (ES_PostToService( MyPriority, ThisEvent) == true)
+  if (ES_PostToService( Ctx.MyPriority, ThisEvent) == true)
   {
       return true;
   }else
@@ -127,7 +118,7 @@ bool InitDisarmFSM ( uint8_t Priority )
 ****************************************************************************/
 bool PostDisarmFSM( ES_Event ThisEvent )
 {
-  return ES_PostToService( MyPriority, ThisEvent);
+  return ES_PostToService( Ctx.MyPriority, ThisEvent);
 }
 
 /****************************************************************************
@@ -151,11 +142,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
   ES_Event ReturnEvent;
   ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
 	
-	// initial state: all the LEDs are off.
-	static char LEDs[8] = {OFF, OFF, OFF, OFF, OFF, OFF , OFF, OFF}; 
-	static bool tower_rotate_direction = true;
-	
-  switch ( CurrentState )
+  switch ( Ctx.CurrentState )
   {
     case Armed :
 			switch ( ThisEvent.EventType ) {
@@ -168,13 +155,17 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					setArmed(); 
 					printf(" Setting all tower LEDS off...\r\n");
 					LEDShiftRegInit();
-					// all LEDs are off when armed
-					setLED (LEDs); 
+					// all LEDs are off when armed, including the ones lit by
+					// the last game, and the dialed tiers start over
+					setLEDs(0);
+					postAnimation(NoAnimation);
+					Ctx.Dialed = false;
 				
 					printf(" Generating random passwords...\r\n");
 				  // generate random password for keyboard input
 					randomizePasswords();
 					printArmedMessage();
+					LCDstopCountdown();
 				
 					printf(" Lowering flag...\r\n");
 				  // lower the flag when armed
@@ -200,9 +191,8 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					printf("EVENT: Three hands detected.\r\n");
 				
 					printf(" Setting Tower Tier 1 LED on...\r\n");
-					LEDs[Tier1] = ON;
 					// light up the LED for bottom layer to show success in task 1
-					setLED(LEDs);
+					turnOnLEDs(LED_TIER1);
 				
 					printf(" Begin printing LCD passcode...\r\n");
 					resetLCDmessage();
@@ -215,11 +205,13 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					//the timer can only go up to 32000
 					ES_Timer_InitTimer(DISARM_TIMER, 30000);
 					ES_Timer_StartTimer(DISARM_TIMER);
+					// and shows the time left as a bar under the passcodes
+					LCDstartCountdown(30000);
 					//begins to run the timing motor
 					unwindTimingMotor(); 
 				
 					// grabs current time to store for rewinding the timer motor
-					startTime = ES_Timer_GetTime();
+					Ctx.startTime = ES_Timer_GetTime();
 
 					ES_Event ThisEvent;
 					ThisEvent.EventType = PLAY_TRACK;
@@ -228,18 +220,18 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					PostAdafruitAudioService(ThisEvent);
 					
 					printf(" Transitioning to Stage 1...\r\n\r\n");
-					CurrentState = Stage1;
+					Ctx.CurrentState = Stage1;
 					printf("STATE: Stage1\r\n\r\n");
 					break;
 	
 				case ES_TIMEOUT :
 					// if panic timer expires
 					if (ThisEvent.EventParam == PANIC_TIMER) {
-						if (tower_rotate_direction) {
-							tower_rotate_direction = false;
+						if (Ctx.tower_rotate_direction) {
+							Ctx.tower_rotate_direction = false;
 							rotateTowerRight();
 						} else {
-							tower_rotate_direction = true;
+							Ctx.tower_rotate_direction = true;
 							rotateTowerLeft();
 						}
 						ES_Timer_InitTimer(PANIC_TIMER, 350);
@@ -265,9 +257,9 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 						printf("EVENT: Time has run out!\r\n");
 						printTimeUp();
 						// gets the time when the game ended
-						endTime = ES_Timer_GetTime(); 
+						Ctx.endTime = ES_Timer_GetTime(); 
 						// calculate how much rewinding needs to be done
-						ES_Timer_InitTimer(REWIND_TIMER, (endTime-startTime)/2);
+						ES_Timer_InitTimer(REWIND_TIMER, (Ctx.endTime-Ctx.startTime)/2);
 						ES_Timer_StartTimer(REWIND_TIMER);
 						// begins rewinding the clock motor
 						rewindTimingMotor(); 
@@ -275,7 +267,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 						ThisEvent.EventType = ES_INIT;
 						PostDisarmFSM(ThisEvent);
 						// go back to armed state
-						CurrentState = Armed;
+						Ctx.CurrentState = Armed;
 					}
 					// if vibration timer expires
 					if (ThisEvent.EventParam == VIBRATION_TIMER) {
@@ -298,12 +290,11 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					printArmedMessage();
 					printf(" Setting Tower Tier 1 LED off...\r\n");
 					// task 1 is not completed 
-					LEDs[Tier1] = OFF;
 					// turn off the LED for bottom layer
-				  setLED(LEDs);
+					turnOffLEDs(LED_TIER1);
 				
 					printf(" Transitioning to Stage1_Stagnated...\r\n\r\n");
-					CurrentState = Stage1_Stagnated;
+					Ctx.CurrentState = Stage1_Stagnated;
 					printf("STATE: Stage1_Stagnated\r\n\r\n");
         break;
 				
@@ -316,9 +307,8 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					printAuthorizedMessage();
 				
 					printf(" Setting Tower Tier 2 LED on...\r\n");
-					LEDs[Tier2] = ON;
 					// turn on LED on the second tier to show success
-				  setLED(LEDs);
+					turnOnLEDs(LED_TIER2);
 				
 					printf(" Playing audio: Wahoo!...\r\n");
 				  ES_Event ThisEvent;
@@ -328,7 +318,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					PostAdafruitAudioService(ThisEvent);	
 					printf(" Transitioning to Stage2...\r\n\r\n");
 					// set the current state to state 2
-					CurrentState = Stage2;
+					Ctx.CurrentState = Stage2;
 					printf("STATE: Stage2\r\n\r\n");
           break;
 				
@@ -354,9 +344,9 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
           if (ThisEvent.EventParam == DISARM_TIMER) {
 						printf("EVENT: Time has run out!\r\n");
 						printTimeUp();
-						endTime = ES_Timer_GetTime();
+						Ctx.endTime = ES_Timer_GetTime();
 						// calculate how much rewinding needs to be done
-						ES_Timer_InitTimer(REWIND_TIMER, (endTime-startTime)/2);
+						ES_Timer_InitTimer(REWIND_TIMER, (Ctx.endTime-Ctx.startTime)/2);
 						ES_Timer_StartTimer(REWIND_TIMER);
 						// begins rewinding the timing motor
 						rewindTimingMotor(); 
@@ -364,7 +354,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 						ThisEvent.EventType = ES_INIT;
 						PostDisarmFSM(ThisEvent);
 						// go back to armed state
-						CurrentState = Armed;
+						Ctx.CurrentState = Armed;
 					}
           break;
 				
@@ -373,9 +363,8 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					printf("EVENT: Three hands detected.\r\n");
 				
 					printf(" Setting Tower Tier 1 LED on...\r\n");
-					LEDs[Tier1] = ON;
 					// light up the LED for bottom layer to show success in task 1
-					setLED(LEDs);
+					turnOnLEDs(LED_TIER1);
 				
 					printf(" Begin printing LCD passcode...\r\n");
 					resetLCDmessage();
@@ -393,7 +382,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 
 					printf(" Transitioning to Stage1...\r\n\r\n");
 					// set current stage to stage 1
-					CurrentState = Stage1;
+					Ctx.CurrentState = Stage1;
 					printf("STATE: Stage1\r\n\r\n");
           break;
 
@@ -411,16 +400,16 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 						printf("EVENT: Time has run out!\r\n");
 						printTimeUp();
 						// gets the time when the game ended
-						endTime = ES_Timer_GetTime();
+						Ctx.endTime = ES_Timer_GetTime();
 						// calculate how much rewinding needs to be done
-						ES_Timer_InitTimer(REWIND_TIMER, (endTime-startTime)/2);
+						ES_Timer_InitTimer(REWIND_TIMER, (Ctx.endTime-Ctx.startTime)/2);
 						ES_Timer_StartTimer(REWIND_TIMER);
 						// begins rewinding the clock moto
-						rewindTimingMotor(); r
+						rewindTimingMotor(); 
 						
 						ThisEvent.EventType = ES_INIT;
 						PostDisarmFSM(ThisEvent);
-						CurrentState = Armed;
+						Ctx.CurrentState = Armed;
           }
 					break;
 					
@@ -429,13 +418,11 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					printf("EVENT: Key has been inserted.\r\n");
 				
 					printf(" Setting Tower Tier 3 LED on...\r\n");
-					LEDs[Tier3] = ON;
 					// light up LED on tier 3 to show successful completion of task 3
-					setLED(LEDs);
+					turnOnLEDs(LED_TIER3);
 				
 					printf(" Setting Dial LED on...\r\n");
-					LEDs[pot] = ON;
-					setLED(LEDs);
+					turnOnLEDs(LED_POT);
 				
 					printf(" Playing audio: Wahoo!...\r\n");
 					ES_Event ThisEvent;
@@ -448,7 +435,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					setPotZero();
 					printf(" Transitioning to Stage3...\r\n\r\n");
 					// set current state to state 3
-					CurrentState = Stage3;
+					Ctx.CurrentState = Stage3;
 					printf("STATE: Stage3\r\n\r\n");
           break;
 
@@ -465,9 +452,9 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					if (ThisEvent.EventParam == DISARM_TIMER) {  
 						printf("EVENT: Time has run out!\r\n");
 						printTimeUp();
-						endTime = ES_Timer_GetTime();
+						Ctx.endTime = ES_Timer_GetTime();
 						// calculate how much rewinding needs to be done
-						ES_Timer_InitTimer(REWIND_TIMER, (endTime-startTime)/2);
+						ES_Timer_InitTimer(REWIND_TIMER, (Ctx.endTime-Ctx.startTime)/2);
 						ES_Timer_StartTimer(REWIND_TIMER);
 						// begins rewinding the clock motor
 						rewindTimingMotor(); 
@@ -475,12 +462,15 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 						ThisEvent.EventType = ES_INIT;
 						PostDisarmFSM(ThisEvent);
 						// set current state to armed
-						CurrentState = Armed;
+						Ctx.CurrentState = Armed;
 					}
-					if (ThisEvent.EventParam == FAST_LEDS) {  
-						printf("EVENT: \r\n");
-						ThisEvent.EventType = CORRECT_VALUE_DIALED;
-						PostDisarmFSM(ThisEvent);
+          break;
+				
+				// if the tiers 4-6 animation is done
+				case ANIMATION_DONE :
+					if (ThisEvent.EventParam == VictoryAnimation) {
+						printf("EVENT: Tiers 4-6 are lit.\r\n");
+						completeDisarm();
 					}
           break;
 				
@@ -489,44 +479,12 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 					printf("EVENT: The correct pot value has been dialed.\r\n");
 					// Sets the armed line to 0V
 					setUnarmed(); 
-					printf(" Setting Tower Tier 4-6 LED on with delay...\r\n");
-					
-					ES_Timer_InitTimer(FAST_LEDS, 150);
-					static int i = Tier4;
-					if (i<=Tier6){
-						printf("\n\r looping for LED i + %d\n\r", i);
-						// turn on all the remaining LEDs one by one
-						LEDs[i] = 0;
-						setLED(LEDs);
-						ES_Timer_StartTimer(FAST_LEDS);
-						i++;
+					// the event checker keeps posting while the pot stays there
+					if (Ctx.Dialed)
 						break;
-					}
-					printf(" Raising the flag...\r\n");
-					// raise flag to show hope and joy
-					raiseFlag();
-					printf(" Playing audio: victory song...\r\n");
-					ES_Event ThisEvent;
-					ThisEvent.EventType = PLAY_TRACK;
-					// play sound track 03
-					ThisEvent.EventParam = 3; 					
-					PostAdafruitAudioService(ThisEvent);	
-					printf(" Starting 30s post-disarm timer...\r\n");
-					ES_Timer_InitTimer(POST_DISARM_TIMER, 30000);
-					printf(" Raising ball and feather...\r\n");
-					// stop falling ball
-					stopTimingMotor();
-					// get the time when the disarment ends and rearm DDM
-					endTime = ES_Timer_GetTime();
-					ES_Timer_InitTimer(REWIND_TIMER, (endTime-startTime)/2);
-					ES_Timer_StartTimer(REWIND_TIMER);
-					// begins rewinding the clock motor
-					rewindTimingMotor(); 
-					
-					printf(" Transitioning to Stage4...\r\n\r\n");
-					// set current stage to stage 4
-					CurrentState = Stage4;
-					printf("STATE: Stage4\r\n\r\n");
+					Ctx.Dialed = true;
+					printf(" Setting Tower Tier 4-6 LED on with delay...\r\n");
+					postAnimation(VictoryAnimation);
           break;
 
         default :
@@ -544,7 +502,7 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 						ThisEvent.EventType = ES_INIT;
 						PostDisarmFSM(ThisEvent);
 						// set current state to armed
-						CurrentState = Armed;
+						Ctx.CurrentState = Armed;
 					}
 					// if rewind timer expires
 					if (ThisEvent.EventParam == REWIND_TIMER) {
@@ -561,6 +519,8 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
     default :
       ;
   }
+	// the LEDs changed above go out together, in one transfer
+	flushLEDs();
   return ReturnEvent;
 }
 
@@ -581,5 +541,103 @@ ES_Event RunDisarmFSM( ES_Event ThisEvent )
 ****************************************************************************/
 DisarmState_t QueryDisarmFSM ( void )
 {
-   return(CurrentState);
+   return(Ctx.CurrentState);
+}
+
+/****************************************************************************
+ Function
+     InitDisarmFSMContext
+
+ Parameters
+     DisarmFSMContext_t * : the context to set up
+
+ Returns
+     none
+
+ Description
+     sets the power on values of this module's variables: the first panic
+		 swing goes right
+ Notes
+     called by GameContext_Init
+****************************************************************************/
+void InitDisarmFSMContext(DisarmFSMContext_t *pContext)
+{
+	pContext->tower_rotate_direction = true;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+/****************************************************************************
+ Function
+     completeDisarm
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     once tiers 4-6 are lit: raises the flag, plays the victory song, stops
+		 the ball and starts rewinding it, and moves on to Stage4
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void completeDisarm(void)
+{
+	// the animation left them at full brightness; they stay on after it,
+	// and letting it go stops the refresh interrupt
+	turnOnLEDs(DIALED_TIERS);
+	postAnimation(NoAnimation);
+	printf(" Raising the flag...\r\n");
+	// raise flag to show hope and joy
+	raiseFlag();
+	printf(" Playing audio: victory song...\r\n");
+	ES_Event ThisEvent;
+	ThisEvent.EventType = PLAY_TRACK;
+	// play sound track 03
+	ThisEvent.EventParam = 3; 					
+	PostAdafruitAudioService(ThisEvent);	
+	printf(" Starting 30s post-disarm timer...\r\n");
+	ES_Timer_InitTimer(POST_DISARM_TIMER, 30000);
+	printf(" Raising ball and feather...\r\n");
+	// stop falling ball
+	stopTimingMotor();
+	LCDstopCountdown();
+	// get the time when the disarment ends and rearm DDM
+	Ctx.endTime = ES_Timer_GetTime();
+	ES_Timer_InitTimer(REWIND_TIMER, (Ctx.endTime-Ctx.startTime)/2);
+	ES_Timer_StartTimer(REWIND_TIMER);
+	// begins rewinding the clock motor
+	rewindTimingMotor(); 
+	
+	printf(" Transitioning to Stage4...\r\n\r\n");
+	// set current stage to stage 4
+	Ctx.CurrentState = Stage4;
+	printf("STATE: Stage4\r\n\r\n");
+}
+
+/****************************************************************************
+ Function
+     postAnimation
+
+ Parameters
+     LEDAnimation_t : the animation to play, NoAnimation to stop
+
+ Returns
+     none
+
+ Description
+     asks the LED animation service to play an animation on the tower
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void postAnimation(LEDAnimation_t Animation)
+{
+	ES_Event ThisEvent;
+	ThisEvent.EventType = PLAY_ANIMATION;
+	ThisEvent.EventParam = Animation;
+	PostLEDAnimationService(ThisEvent);
 }
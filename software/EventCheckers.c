@@ -21,6 +21,11 @@
 #include "SlotDetector.h"
 #include "DCmotors.h"
 #include "AdafruitAudioService.h"
+#include "GameContext.h"
+
+// what each checker saw last time is kept in EventCheckersContext_t
+// (see GameContext.h)
+#define Ctx (pGame->EventCheckers)
 
 /****************************************************************************
  Function
@@ -124,20 +129,19 @@ bool Check4Keystroke(void)
 ****************************************************************************/
 
 bool CheckTapeSensor(void) {
-	static bool lastState = true;
-	// lastState == false corresponds to being uncovered
-	// lastState == true corresponds to being covered
-	if (tapeSensorsCovered() && (lastState == false)) {
+	// lastTapeState == false corresponds to being uncovered
+	// lastTapeState == true corresponds to being covered
+	if (tapeSensorsCovered() && (Ctx.lastTapeState == false)) {
 		ES_Event ThisEvent;
     ThisEvent.EventType = THREE_HANDS_ON ;
     PostDisarmFSM( ThisEvent );
-		lastState = true;
+		Ctx.lastTapeState = true;
 		return true;
-	} else if (!(tapeSensorsCovered()) && (lastState == true)) {
+	} else if (!(tapeSensorsCovered()) && (Ctx.lastTapeState == true)) {
 		ES_Event ThisEvent;
     ThisEvent.EventType = THREE_HANDS_OFF ;
     PostDisarmFSM( ThisEvent );
-		lastState = false;
+		Ctx.lastTapeState = false;
 		return true;
 	}
 	return false;
@@ -158,25 +162,24 @@ bool CheckTapeSensor(void) {
 	Both types of change will trigger the KEY_INSERTED event.
 ****************************************************************************/
 bool CheckSlotDetector(void) {
-	static bool lastState = true;
 	bool keyInSlot = isKeyInSlot();
 
 	// Checks if key has been placed into slot
-	if (keyInSlot && (lastState == false)) {
+	if (keyInSlot && (Ctx.lastSlotState == false)) {
 		printf("Key has been placed.\r\n");
-		lastState = true;
+		Ctx.lastSlotState = true;
 		ES_Event ThisEvent;
     	ThisEvent.EventType = KEY_INSERTED;
     PostDisarmFSM( ThisEvent );
 		return true;
 
 	// Checks if key has been removed from slot
-	} else if (!keyInSlot && (lastState == true)) {
+	} else if (!keyInSlot && (Ctx.lastSlotState == true)) {
 		printf("Key has been removed.\r\n");
 		ES_Event ThisEvent;
     	ThisEvent.EventType = KEY_INSERTED;
     PostDisarmFSM( ThisEvent );
-		lastState = false;
+		Ctx.lastSlotState = false;
 		return true;
 	}
 	return false;
@@ -196,7 +199,6 @@ bool CheckSlotDetector(void) {
 ****************************************************************************/
 
 bool CheckPot(void) {
-	static double lastPotValue = -1;
 	double potZero = getPotZero();
 	double potValue = getPotValue();
 	bool victory = getVictory();
@@ -226,11 +228,30 @@ bool CheckPot(void) {
 		setVictory(true);
 		return true;
 	// Check for pot changes and moves the tower accordingly
-	} else if (potValue < (lastPotValue - 0.05) || potValue > (lastPotValue + 0.05)) {
+	} else if (potValue < (Ctx.lastPotValue - 0.05) || potValue > (Ctx.lastPotValue + 0.05)) {
 		moveTower(potValue);
-		lastPotValue = potValue;
+		Ctx.lastPotValue = potValue;
 	}
 	return false;
 	
 }
 
+/****************************************************************************
+ Function
+   InitEventCheckersContext
+ Parameters
+   EventCheckersContext_t * : the context to set up
+ Returns
+   None
+ Description
+   Sets the power on values of what the checkers saw last: tape sensors
+	 covered, key in the slot and no pot reading yet
+ Notes
+	Called by GameContext_Init
+****************************************************************************/
+void InitEventCheckersContext(EventCheckersContext_t *pContext)
+{
+	pContext->lastTapeState = true;
+	pContext->lastSlotState = true;
+	pContext->lastPotValue = -1;
+}
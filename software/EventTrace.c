@@ -0,0 +1,408 @@
+/****************************************************************************
+ Module
+   EventTrace.c
+
+ Revision
+   1.0.1
+
+ Description
+   Records the events posted to the services into a ring buffer of delta
+	 time varint records, and decodes those records again (see EventTrace.h
+	 for the format).
+
+ Notes
+   Nothing here touches the hardware, so the same code records on the Tiva
+	 and on the host. Posts come from interrupts as well (the timers, the
+	 key pad's row interrupt), so a record is added, and records are taken
+	 off the ring, with interrupts off.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+#include "EventTrace.h"
+#include "GameContext.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// the ring and what was recorded so far are kept in EventTraceContext_t
+// (see GameContext.h)
+#define Ctx (pGame->Trace)
+
+// a record is at most 3 varints of 64, 32 and 16 bits
+#define MAX_RECORD_SIZE 18
+#define MAX_VARINT_SIZE 10
+
+#define STIMULUS_BIT 0x10
+#define SERVICE_MASK 0x0f
+#define DELTA_SHIFT 5
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t putVarint(uint8_t *pDest, uint64_t Value);
+static bool getVarint(const uint8_t *pTrace, uint32_t Length, uint32_t *pOffset,
+		uint64_t *pValue);
+static bool isKeyPadScan(ES_Event ThisEvent);
+static void addRecord(uint8_t Service, ES_Event ThisEvent, uint32_t Tick,
+		bool Stimulus);
+static uint64_t ringVarint(uint16_t *pPos);
+static uint16_t frontRecord(uint32_t *pDelta);
+static void dropFront(uint16_t Size, uint32_t Delta);
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     EventTrace_Start
+
+ Parameters
+     uint32_t : tick count the trace starts at
+
+ Returns
+     none
+
+ Description
+     throws away whatever is in the ring and starts recording
+ Notes
+
+****************************************************************************/
+void EventTrace_Start(uint32_t Tick) {
+	Ctx.Head = 0;
+	Ctx.Count = 0;
+	Ctx.FrontTick = Tick & EVENT_TRACE_TICK_MASK;
+	Ctx.LastTick = Ctx.FrontTick;
+	Ctx.Records = 0;
+	Ctx.Lost = 0;
+	Ctx.StartSent = false;
+	Ctx.Recording = true;
+}
+
+/****************************************************************************
+ Function
+     EventTrace_Stop
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     stops recording, leaving the ring to be read
+ Notes
+
+****************************************************************************/
+void EventTrace_Stop(void) {
+	Ctx.Recording = false;
+}
+
+/****************************************************************************
+ Function
+     EventTrace_Record
+
+ Parameters
+     uint8_t : service the event was posted to
+		 ES_Event : the event
+		 uint32_t : tick count at the time of the post
+		 bool : true if the event checkers posted it
+
+ Returns
+     none
+
+ Description
+     encodes the post as one record at the end of the ring, dropping the
+		 oldest records if there is no room
+ Notes
+     called for every post, so it returns at once when not recording; the
+		 key pad scan is left out (see EventTrace.h)
+****************************************************************************/
+void EventTrace_Record(uint8_t Service, ES_Event ThisEvent, uint32_t Tick,
+		bool Stimulus) {
+	if (!Ctx.Recording || isKeyPadScan(ThisEvent))
+		return;
+	addRecord(Service, ThisEvent, Tick, Stimulus);
+}
+
+/****************************************************************************
+ Function
+     EventTrace_RecordStimulus
+
+ Parameters
+     uint8_t : service the stimulus is for
+		 ES_Event : the stimulus
+		 uint32_t : tick count at the time it came in
+
+ Returns
+     none
+
+ Description
+     encodes a stimulus that did not come through a post from the event
+		 checkers as one record at the end of the ring
+ Notes
+     PutKeyPadKey records every key this way, which is how keys come back
+		 in a replay
+****************************************************************************/
+void EventTrace_RecordStimulus(uint8_t Service, ES_Event ThisEvent,
+		uint32_t Tick) {
+	if (!Ctx.Recording)
+		return;
+	addRecord(Service, ThisEvent, Tick, true);
+}
+
+/****************************************************************************
+ Function
+     EventTrace_Read
+
+ Parameters
+     uint8_t * : where to put the bytes
+		 uint16_t : room at pDest
+
+ Returns
+     uint16_t : bytes put at pDest
+
+ Description
+     takes whole records off the front of the ring. The first read after
+		 EventTrace_Start begins with the StartTick, so the bytes of every read
+		 put end to end make one trace
+ Notes
+     interrupts are off while the records are moved, at most Size bytes
+
+****************************************************************************/
+uint16_t EventTrace_Read(uint8_t *pDest, uint16_t Size) {
+	uint16_t moved = 0;
+
+	if (!Ctx.StartSent) {
+		uint8_t start[MAX_VARINT_SIZE];
+		uint8_t size = putVarint(start, Ctx.FrontTick);
+		if (size > Size)
+			return 0;
+		for (uint8_t i = 0; i < size; i++) {
+			pDest[moved++] = start[i];
+		}
+		Ctx.StartSent = true;
+	}
+
+	EnterCritical();
+	while (Ctx.Count > 0) {
+		uint32_t delta;
+		uint16_t size = frontRecord(&delta);
+		if (size > Size - moved)
+			break;
+		for (uint16_t i = 0; i < size; i++) {
+			pDest[moved++] = Ctx.Buffer[(Ctx.Head + i) % EVENT_TRACE_SIZE];
+		}
+		dropFront(size, delta);
+	}
+	ExitCritical();
+	return moved;
+}
+
+/****************************************************************************
+ Function
+     EventTrace_Count
+
+ Parameters
+     none
+
+ Returns
+     uint32_t : records since EventTrace_Start
+
+ Description
+     counts every record made, whether or not it is still in the ring
+ Notes
+
+****************************************************************************/
+uint32_t EventTrace_Count(void) {
+	return Ctx.Records;
+}
+
+/****************************************************************************
+ Function
+     EventTrace_Lost
+
+ Parameters
+     none
+
+ Returns
+     uint16_t : records dropped since EventTrace_Start
+
+ Description
+     counts the records pushed out of a full ring before they were read
+ Notes
+
+****************************************************************************/
+uint16_t EventTrace_Lost(void) {
+	return Ctx.Lost;
+}
+
+/****************************************************************************
+ Function
+     EventTrace_DecodeStart
+
+ Parameters
+     const uint8_t * : the trace
+		 uint32_t : bytes in the trace
+		 uint32_t * : offset to decode at, moved past the StartTick
+		 uint32_t * : where to put the StartTick
+
+ Returns
+     bool : false if the trace is cut short
+
+ Description
+     reads the tick count a trace starts at
+ Notes
+
+****************************************************************************/
+bool EventTrace_DecodeStart(const uint8_t *pTrace, uint32_t Length,
+		uint32_t *pOffset, uint32_t *pTick) {
+	uint64_t tick;
+
+	if (!getVarint(pTrace, Length, pOffset, &tick))
+		return false;
+	*pTick = (uint32_t)tick;
+	return true;
+}
+
+/****************************************************************************
+ Function
+     EventTrace_Decode
+
+ Parameters
+     const uint8_t * : the trace
+		 uint32_t : bytes in the trace
+		 uint32_t * : offset of the record, moved past it
+		 EventRecord_t * : the record before, overwritten with this one
+
+ Returns
+     bool : false at the end of the trace or if the record is cut short
+
+ Description
+     reads one record, turning its delta back into a tick count
+ Notes
+     *pOffset is left alone when false is returned
+****************************************************************************/
+bool EventTrace_Decode(const uint8_t *pTrace, uint32_t Length,
+		uint32_t *pOffset, EventRecord_t *pRecord) {
+	uint32_t offset = *pOffset;
+	uint64_t header, type, param;
+
+	if (!getVarint(pTrace, Length, &offset, &header)
+			|| !getVarint(pTrace, Length, &offset, &type)
+			|| !getVarint(pTrace, Length, &offset, &param))
+		return false;
+
+	pRecord->Tick += (uint32_t)(header >> DELTA_SHIFT);
+	pRecord->Stimulus = ((header & STIMULUS_BIT) != 0);
+	pRecord->Service = (uint8_t)(header & SERVICE_MASK);
+	pRecord->Event.EventType = (ES_EventTyp_t)type;
+	pRecord->Event.EventParam = (uint16_t)param;
+	*pOffset = offset;
+	return true;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// true for the events of the key pad scan, which the trace leaves out
+static bool isKeyPadScan(ES_Event ThisEvent) {
+	return (ThisEvent.EventType == KEYPAD_ROW_EDGE)
+			|| (ThisEvent.EventType == KEYPAD_KEYS)
+			|| ((ThisEvent.EventType == ES_TIMEOUT)
+					&& (ThisEvent.EventParam == KEYPAD_TIMER));
+}
+
+// encodes one record at the end of the ring, dropping the oldest records
+// if there is no room; interrupts are off, as posts come from them too
+static void addRecord(uint8_t Service, ES_Event ThisEvent, uint32_t Tick,
+		bool Stimulus) {
+	uint8_t record[MAX_RECORD_SIZE];
+	uint8_t size;
+
+	EnterCritical();
+	uint32_t delta = (Tick - Ctx.LastTick) & EVENT_TRACE_TICK_MASK;
+	Ctx.LastTick = Tick & EVENT_TRACE_TICK_MASK;
+
+	size = putVarint(record, ((uint64_t)delta << DELTA_SHIFT)
+			| (Stimulus ? STIMULUS_BIT : 0) | (Service & SERVICE_MASK));
+	size += putVarint(&record[size], (uint64_t)ThisEvent.EventType);
+	size += putVarint(&record[size], ThisEvent.EventParam);
+
+	while (EVENT_TRACE_SIZE - Ctx.Count < size) {
+		uint32_t lostDelta;
+		uint16_t lostSize = frontRecord(&lostDelta);
+		dropFront(lostSize, lostDelta);
+		Ctx.Lost++;
+	}
+
+	for (uint8_t i = 0; i < size; i++) {
+		Ctx.Buffer[(Ctx.Head + Ctx.Count) % EVENT_TRACE_SIZE] = record[i];
+		Ctx.Count++;
+	}
+	Ctx.Records++;
+	ExitCritical();
+}
+
+// writes Value as a varint, returns the bytes written
+static uint8_t putVarint(uint8_t *pDest, uint64_t Value) {
+	uint8_t size = 0;
+
+	while (Value >= 0x80) {
+		pDest[size++] = (uint8_t)(Value | 0x80);
+		Value >>= 7;
+	}
+	pDest[size++] = (uint8_t)Value;
+	return size;
+}
+
+// reads a varint from a flat trace, false if it runs off the end
+static bool getVarint(const uint8_t *pTrace, uint32_t Length, uint32_t *pOffset,
+		uint64_t *pValue) {
+	uint64_t value = 0;
+	uint32_t offset = *pOffset;
+
+	for (uint8_t i = 0; i < MAX_VARINT_SIZE; i++) {
+		if (offset >= Length)
+			return false;
+		uint8_t byte = pTrace[offset++];
+		value |= (uint64_t)(byte & 0x7f) << (7 * i);
+		if ((byte & 0x80) == 0) {
+			*pValue = value;
+			*pOffset = offset;
+			return true;
+		}
+	}
+	return false;
+}
+
+// reads a varint *pPos bytes into the ring; the ring only holds whole records
+static uint64_t ringVarint(uint16_t *pPos) {
+	uint64_t value = 0;
+	uint8_t shift = 0;
+	uint8_t byte;
+
+	do {
+		byte = Ctx.Buffer[(Ctx.Head + *pPos) % EVENT_TRACE_SIZE];
+		(*pPos)++;
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+// returns the size and the delta of the oldest record in the ring
+static uint16_t frontRecord(uint32_t *pDelta) {
+	uint16_t pos = 0;
+
+	*pDelta = (uint32_t)(ringVarint(&pos) >> DELTA_SHIFT);
+	ringVarint(&pos);
+	ringVarint(&pos);
+	return pos;
+}
+
+// takes the oldest record off the ring
+static void dropFront(uint16_t Size, uint32_t Delta) {
+	Ctx.Head = (Ctx.Head + Size) % EVENT_TRACE_SIZE;
+	Ctx.Count -= Size;
+	Ctx.FrontTick = (Ctx.FrontTick + Delta) & EVENT_TRACE_TICK_MASK;
+}
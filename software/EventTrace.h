@@ -0,0 +1,129 @@
+/****************************************************************************
+
+  Header file for EventTrace.c -- a compact record of every event posted
+
+ ****************************************************************************/
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+
+/* NOTES:
+
+	While recording, every event posted to a service is added to a ring
+	buffer, oldest first, as a small record. Reading the trace takes whole
+	records off the front of the ring, so it can be streamed out (UART, file)
+	a few bytes at a time while the game goes on.
+
+	Format
+	----------------------------------------
+	Every number is a varint: 7 bits per byte, least significant first, the
+	top bit set on every byte but the last.
+
+		trace  := StartTick record*
+		record := (Delta << 5 | Stimulus << 4 | Service) EventType EventParam
+
+	Delta is the ticks since the record before (since StartTick for the
+	first one). Stimulus is set for events posted by the event checkers, that
+	is events that came from outside the firmware; everything else (timers,
+	services posting to each other) follows from those. A typical record is
+	3 to 5 bytes.
+
+	The key pad is the exception: it is scanned by the service itself, from
+	its row interrupt and the KEYPAD_TIMER, so nothing a checker posts
+	stands for a key. Each debounced key going down or up is recorded as a
+	stimulus instead, by PutKeyPadKey, with EventType KEYPAD_KEYS and
+	EventParam the key, KEYPAD_KEY_DOWN set if it went down. The scan that
+	finds the keys (KEYPAD_ROW_EDGE, the KEYPAD_TIMER timeouts) and the
+	KEYPAD_KEYS posts themselves follow from those records or from pins the
+	host does not have, so they are left out of the trace.
+
+	Hooking it up
+	----------------------------------------
+	The host framework (host/HostFramework.c) records every post by itself.
+	On the Tiva, add to the end of ES_PostToService in ES_Framework.c
+
+		EventTrace_Record(WhichService, TheEvent, ES_Timer_GetTime(), InCheckers);
+
+	with InCheckers set around the call to ES_CheckUserEvents in ES_Run.
+	The Tiva tick is only 16 bits wide, so a gap of more than 65535 ticks
+	between two events is lost; the PANIC_TIMER keeps the gaps far shorter.
+
+	ES_PostToService is called from interrupts too (the timer tick,
+	KeyPadRowISR), so EventTrace_Record and EventTrace_Read change the ring
+	between EnterCritical and ExitCritical, and the hook needs no lock of
+	its own. A post from an interrupt that comes in while the checkers run
+	is not a stimulus though; where that can happen, pass
+
+		InCheckers && ((HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_VEC_ACT_M) == 0)
+
+	instead of InCheckers, which is false inside an interrupt.
+
+	If the ring fills up before it is read, the oldest records are dropped
+	and counted (EventTrace_Lost). A trace with drops cannot be replayed.
+*/
+
+// bytes in the ring buffer, enough for about 200 events
+#ifndef EVENT_TRACE_SIZE
+#define EVENT_TRACE_SIZE 1024
+#endif
+
+// width of the tick count handed to EventTrace_Record
+#ifdef HOST_SIM
+#include "HostSim.h"
+#define EVENT_TRACE_TICK_MASK 0xffffffffUL
+#define EVENT_TRACE_TICK() HostSim_GetTicks()
+#else
+#define EVENT_TRACE_TICK_MASK 0xffffUL // ES_Timer_GetTime
+#define EVENT_TRACE_TICK() ES_Timer_GetTime()
+#endif
+
+// one decoded record
+typedef struct {
+	uint32_t Tick;
+	uint8_t Service;
+	bool Stimulus;
+	ES_Event Event;
+} EventRecord_t;
+
+// Public Function Prototypes
+
+// empties the ring and starts recording, the trace starting at Tick
+void EventTrace_Start(uint32_t Tick);
+
+// stops recording; what is in the ring can still be read
+void EventTrace_Stop(void);
+
+// adds one posted event to the ring, if recording
+void EventTrace_Record(uint8_t Service, ES_Event ThisEvent, uint32_t Tick,
+		bool Stimulus);
+
+// adds a stimulus that was not posted by a checker (a key pad key) to the
+// ring, if recording
+void EventTrace_RecordStimulus(uint8_t Service, ES_Event ThisEvent,
+		uint32_t Tick);
+
+// moves the StartTick (first read only) and as many whole records as fit
+// into pDest, returns the number of bytes moved
+uint16_t EventTrace_Read(uint8_t *pDest, uint16_t Size);
+
+// returns the records recorded since EventTrace_Start, dropped ones included
+uint32_t EventTrace_Count(void);
+
+// returns the records dropped because the ring was full
+uint16_t EventTrace_Lost(void);
+
+// decodes the StartTick at the front of a trace
+bool EventTrace_DecodeStart(const uint8_t *pTrace, uint32_t Length,
+		uint32_t *pOffset, uint32_t *pTick);
+
+// decodes the record at *pOffset; pRecord->Tick must hold the tick of the
+// record before (or the StartTick)
+bool EventTrace_Decode(const uint8_t *pTrace, uint32_t Length,
+		uint32_t *pOffset, EventRecord_t *pRecord);
+
+#endif /* EVENT_TRACE_H */
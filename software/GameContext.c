@@ -0,0 +1,60 @@
+/****************************************************************************
+ Module
+   GameContext.c
+
+ Description
+   Holds the context of the station that is running. On the Tiva that is
+	 the one Board below; the host runner points each thread at a station of
+	 its own.
+****************************************************************************/
+#include <string.h>
+
+#include "GameContext.h"
+
+/* Module level variables */
+// the only station on the Tiva, and the default one on the host
+static GameContext_t Board;
+
+CONTEXT_LOCAL GameContext_t *pGame = &Board;
+
+/****************************************************************************
+ Function
+     GameContext_Init
+
+ Parameters
+     GameContext_t * : the context to reset
+
+ Returns
+     none
+
+ Description
+     clears the context, then lets each module put back whatever power on
+		 values are not zero
+ Notes
+     does not select the context
+****************************************************************************/
+void GameContext_Init(GameContext_t *pContext) {
+	memset(pContext, 0, sizeof(GameContext_t));
+	InitDisarmFSMContext(&pContext->DisarmFSM);
+	InitServosContext(&pContext->Servos);
+	InitEventCheckersContext(&pContext->EventCheckers);
+}
+
+/****************************************************************************
+ Function
+     GameContext_Select
+
+ Parameters
+     GameContext_t * : the context to run
+
+ Returns
+     none
+
+ Description
+     every module uses this context from now on (on this thread)
+ Notes
+
+****************************************************************************/
+void GameContext_Select(GameContext_t *pContext) {
+	pGame = pContext;
+}
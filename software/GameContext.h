@@ -0,0 +1,220 @@
+/****************************************************************************
+
+  Header file for GameContext.c -- everything one station remembers
+
+ ****************************************************************************/
+
+#ifndef GAME_CONTEXT_H
+#define GAME_CONTEXT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "DisarmFSM.h"
+#include "KeyPadFSM.h"
+#include "passwordGenerator.h"
+#include "LCD.h"
+#include "LEDs.h"
+#include "EventTrace.h"
+#include "ShiftBus.h"
+
+/* NOTES:
+
+	The state machines and drivers used to keep their variables as file
+	statics, which only allows one game per program. Those variables now live
+	in the structs below, and each module reaches its own part through pGame,
+	the context of the station that is currently running.
+
+	On the Tiva there is only ever one station: main.c calls
+	GameContext_Init(pGame) before ES_Initialize and nothing else changes.
+
+	On the host (HOST_SIM) pGame is thread local, so every worker thread of
+	the host runner can run its own station. A thread switches to another
+	station with GameContext_Select (see host/HostStation.h, which does that
+	together with the simulated hardware).
+
+	Adding a module variable
+	----------------------------------------
+	Put it in that module's struct here, give it its power on value in the
+	module's Init...Context function if that value is not zero, and use it
+	as Ctx.Name in the module.
+*/
+
+#ifdef HOST_SIM
+#define CONTEXT_LOCAL _Thread_local
+#else
+#define CONTEXT_LOCAL
+#endif
+
+// DisarmFSM.c
+typedef struct {
+	DisarmState_t CurrentState;
+	uint16_t startTime;
+	uint16_t endTime;
+	uint8_t MyPriority;
+	bool tower_rotate_direction;
+	bool Dialed; // the pot has been dialed and tiers 4-6 are lighting up
+} DisarmFSMContext_t;
+
+// KeyPadFSM.c
+typedef struct {
+	KeyPadFSMState_t CurrentState;
+	bool Scanning; // the KEYPAD_TIMER is sampling the key pad
+	uint16_t Keys; // debounced keys down, bit per key
+	uint8_t Integrator[NUM_KEYS]; // debounce count of each key
+	KeyRecord_t Fifo[KEYPAD_FIFO_SIZE]; // keys not taken yet
+	volatile uint8_t FifoHead; // records ever put, written by PutKeyPadKey only
+	volatile uint8_t FifoTail; // records ever taken, written by RunKeyPadFSM only
+	uint16_t FifoLost; // keys dropped because the FIFO was full
+	volatile bool PostPending; // a KEYPAD_KEYS post found the queue full
+	uint8_t Match; // password automaton state after the keys typed so far
+	uint8_t sizeOfInput; // keys typed since Enter, up to MAX_PASS_SIZE
+	uint8_t MyPriority;
+} KeyPadFSMContext_t;
+
+// passwordGenerator.c
+typedef struct {
+	uint8_t correctPassword; // 1 to NUM_PASSWORDS
+	uint32_t passwords[NUM_PASSWORDS]; // packed, see passwordGenerator.h
+	// the automaton over the four passwords, built by randomizePasswords
+	uint8_t Next[PASSWORD_STATES][NUM_DIGITS]; // state after each digit
+	uint8_t Matches[PASSWORD_STATES]; // passwords each state ends, bit 0 for password 1
+	uint32_t random[4]; // state of the password generator, xoshiro128**
+	uint32_t pool[4]; // ADC noise collected for the generator
+	uint8_t poolIndex; // pool word the next sample goes into
+} PasswordContext_t;
+
+// LCD.c
+typedef struct {
+	char LCD; // what was last put on the shift register
+	uint8_t messageNumber;
+	uint8_t MyPriority;
+	// nibbles waiting for the LCD service, and whether LCD_TIMER is running
+	uint8_t queue[LCD_QUEUE_SIZE];
+	uint8_t queueHead;
+	uint8_t queueCount;
+	bool draining;
+	// what the lines should show, and what has been queued for them so far
+	char frame[LCD_LINES][LCD_COLUMNS];
+	char shown[LCD_LINES][LCD_COLUMNS];
+	bool dirty; // frame has changed since it was last compared with shown
+	uint8_t line; // where LCDputchar writes next
+	uint8_t column;
+	uint8_t address; // the LCD's DDRAM address once the queue has been sent
+	char pages[LCD_PAGES][LCD_COLUMNS + 1]; // text of printLCDmessage's messages
+	bool glyphsLoaded; // the countdown glyphs are in CGRAM (or queued)
+	// the countdown bar on the second line
+	bool countdownOn;
+	uint16_t countdownStart; // tick it started on
+	uint16_t countdownTicks; // ticks it lasts
+} LCDContext_t;
+
+// LEDs.c, the brightness the refresh interrupt shows
+typedef struct {
+	uint8_t animated[LED_REGISTERS]; // LEDs whose brightness the planes set
+	uint8_t bits[LED_LEVEL_BITS][LED_REGISTERS]; // plane k: bit k of each level
+} LEDPlanes_t;
+
+// LEDs.c
+typedef struct {
+	// one byte per 595 in the chain, bank 0 nearest the Tiva
+	uint8_t lit[LED_REGISTERS]; // the LEDs that should be on, one bit each
+	uint8_t sent[LED_REGISTERS]; // the LEDs the chain has on
+	bool dirty[LED_REGISTERS]; // lit has been changed since the last flushLEDs
+	bool known; // sent is what the chain holds
+	// planes being shown, and the ones setLEDLevels writes before swapping
+	LEDPlanes_t planes[2];
+	uint8_t front; // the planes being shown
+	uint8_t plane; // the plane LEDRefreshISR sends next
+	bool refreshing; // Timer 2A is running the brightness
+} LEDsContext_t;
+
+// LEDAnimation.c
+typedef struct {
+	uint8_t MyPriority;
+	uint8_t Current; // the LEDAnimation_t playing, or that played last
+	bool Playing; // ANIMATION_TIMER is stepping it
+	uint8_t Keyframe;
+	uint8_t Step; // steps of the keyframe done
+	uint8_t Animated; // the LEDs it moves
+	uint8_t From[8]; // levels when the keyframe began
+	uint8_t Levels[8]; // levels now
+} AnimationContext_t;
+
+// Servos.c
+typedef struct {
+	double potZero;
+	bool victory;
+	uint16_t key_servo_pos;
+	uint16_t tower_servo_pos;
+	uint16_t tower_rotate_servo_pos;
+	uint16_t flag_servo_pos;
+} ServosContext_t;
+
+// EventCheckers.c
+typedef struct {
+	bool lastTapeState;
+	bool lastSlotState;
+	double lastPotValue;
+} EventCheckersContext_t;
+
+// AdafruitAudioService.c
+typedef struct {
+	uint8_t MyPriority;
+	uint8_t track;
+} AudioContext_t;
+
+// EventTrace.c
+typedef struct {
+	uint8_t Buffer[EVENT_TRACE_SIZE];
+	uint16_t Head; // oldest byte in the ring
+	uint16_t Count; // bytes in the ring
+	uint32_t FrontTick; // tick the oldest record's delta counts from
+	uint32_t LastTick; // tick of the newest record
+	uint32_t Records;
+	uint16_t Lost;
+	bool Recording;
+	bool StartSent;
+} EventTraceContext_t;
+
+// ShiftBus.c
+typedef struct {
+	ShiftTransfer_t Queue[SHIFT_BUS_QUEUE_SIZE];
+	volatile uint8_t Head; // oldest transfer
+	volatile uint8_t Count; // transfers queued, the one being sent included
+	volatile bool Sending; // a ShiftBusSend is shifting the queue out
+	uint8_t Lost; // transfers that found the queue full
+} ShiftBusContext_t;
+
+typedef struct {
+	DisarmFSMContext_t DisarmFSM;
+	KeyPadFSMContext_t KeyPadFSM;
+	PasswordContext_t Passwords;
+	LCDContext_t LCD;
+	LEDsContext_t LEDs;
+	AnimationContext_t Animation;
+	ServosContext_t Servos;
+	EventCheckersContext_t EventCheckers;
+	AudioContext_t Audio;
+	EventTraceContext_t Trace;
+	ShiftBusContext_t ShiftBus;
+} GameContext_t;
+
+// the station that is currently running
+extern CONTEXT_LOCAL GameContext_t *pGame;
+
+// Public Function Prototypes
+
+// puts a station's context back to its power on values
+void GameContext_Init(GameContext_t *pContext);
+
+// makes the given station the one that is running (on this thread)
+void GameContext_Select(GameContext_t *pContext);
+
+// power on values of each module, called by GameContext_Init
+void InitDisarmFSMContext(DisarmFSMContext_t *pContext);
+void InitServosContext(ServosContext_t *pContext);
+void InitEventCheckersContext(EventCheckersContext_t *pContext);
+
+#endif /* GAME_CONTEXT_H */
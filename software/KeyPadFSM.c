@@ -28,6 +28,8 @@
 #include "inc/hw_types.h" 
 #include "inc/hw_gpio.h" 
 #include "inc/hw_sysctl.h" 
+#include "inc/hw_nvic.h"
+#include "inc/hw_ints.h"
 #include "driverlib/gpio.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
@@ -35,7 +37,10 @@
 #include "EnablePA25_PB23_PD7_PF0.h"
 #include "LCD.h"
 #include "passwordGenerator.h"
+#include "EventTrace.h"
 #include "ES_ServiceHeaders.h"
+#include "GameContext.h"
+#include "helperFunctions.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define BIT(x) >>(x-1)
@@ -44,10 +49,18 @@
 #define clrScrn() 	printf("\x1b[2J")
 #define goHome()	printf("\x1b[1,1H")
 #define clrLine()	printf("\x1b[K")
-#define ALL_BITS (0xFF<<2)
-#define SCALE_DELAY (uint16_t)6
-#define KEYPAD_TIMER_DELAY 50
-#define MAX_PASS_SIZE 5
+// the row inputs, PD0-3
+#define ROW_PINS ((GPIO_PIN_3)|(GPIO_PIN_2)|(GPIO_PIN_1)|(GPIO_PIN_0))
+// the column outputs: columns 1 and 2 on PB0-1, column 3 on PE4
+#define COL_PINS_B ((GPIO_PIN_1)|(GPIO_PIN_0))
+#define COL_PIN_E (GPIO_PIN_4)
+// setCols bits, column 1 in bit 0
+#define ALL_COLS ((1<<NUM_COLS)-1)
+// FIFO index of a record count
+#define FIFO_INDEX(n) ((n) & (KEYPAD_FIFO_SIZE-1))
+
+// this module's part of the running station's context
+#define Ctx (pGame->KeyPadFSM)
 
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this machine.They should be functions
@@ -56,26 +69,22 @@
 void InitKeyPadPortLines(void);
 void delayShort(uint16_t delayTime);
 void delayLong(uint16_t delayTime);
-uint8_t findNum(void);
+uint8_t findNum(uint8_t Key);
 bool CheckForKeyPadButtonPress(void);
-void setCol(int c, int dir);
-uint8_t readRow(int r);
-void setColsHigh(void);
+void setCols(uint8_t High);
+uint16_t scanMatrix(void);
+bool sampleKeys(void);
+bool takeKey(uint8_t Key);
+void postKeys(void);
+void postPasswordResult(bool Correct);
+bool enableRowInterrupts(void);
+void listenForKeys(void);
 void GeneratePassword(void);
 void printCurrentInput(void);
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well.
-// type of state variable should match htat of enum in header file
-static KeyPadFSMState_t CurrentState;
-static uint8_t prevButtonState = 255;
-static uint8_t Row = 255;
-static uint8_t Col = 255;
-static uint8_t passwordInput[MAX_PASS_SIZE];
-static uint8_t sizeOfInput = 0;
-
-// with the introduction of Gen2, we need a module level Priority var as well
-static uint8_t MyPriority;
+// the state variable, the priority and the rest of this module's variables
+// are kept in KeyPadFSMContext_t (see GameContext.h)
 
 
 /*------------------------------ Module Code ------------------------------*/
@@ -101,13 +110,13 @@ bool InitKeyPadFSM ( uint8_t Priority )
 	InitKeyPadPortLines();
 	
   ES_Event ThisEvent;
-  MyPriority = Priority;
+  Ctx.MyPriority = Priority;
   // put us into the Initial PseudoState
-  CurrentState = InitPState;
+  Ctx.CurrentState = InitPState;
 	
   // post the initial transition event
   ThisEvent.EventType = ES_INIT;
-  if (ES_PostToService( MyPriority, ThisEvent) == true)
+  if (ES_PostToService( Ctx.MyPriority, ThisEvent) == true)
   {
       return true;
   }else
@@ -133,7 +142,7 @@ bool InitKeyPadFSM ( uint8_t Priority )
 ****************************************************************************/
 bool PostKeyPadFSM( ES_Event ThisEvent )
 {
-  return ES_PostToService( MyPriority, ThisEvent);
+  return ES_PostToService( Ctx.MyPriority, ThisEvent);
 }
 
 /****************************************************************************
@@ -147,13 +156,12 @@ bool PostKeyPadFSM( ES_Event ThisEvent )
    ES_Event, ES_NO_EVENT if no error ES_ERROR otherwise
 
  Description
-   If a keypad button press event is detected, this function is called to
-   process the event. It collects a series of numbers input by the user until 
-   the 'Enter' key is pressed. The function detects which key pad button was 
-   pressed, and limits the number of numbers that the user can enter before 
-   pressing 'Enter'. Once 'Enter' is pressed, the function checks whether the previous 
-   series of numbers input by the user matches the input password. The appropriate
-   events are posted to DisarmFSM.
+   Samples the key pad while a key may be down (see KeyPadFSM.h) and turns
+   the debounced presses into KEYPAD_KEYS events. For each key pressed it
+   follows the numbers input by the user through the password automaton
+   until the 'Enter' key is pressed. Once 'Enter' is pressed, the function
+   checks whether the last numbers input by the user match the correct
+   password. The appropriate events are posted to DisarmFSM.
   
  Notes
 
@@ -162,36 +170,58 @@ ES_Event RunKeyPadFSM( ES_Event ThisEvent )
 {
   ES_Event ReturnEvent;
   ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+	// a KEYPAD_KEYS post that found the queue full is made again now that
+	// this event has left room in it
+	if (Ctx.PostPending)
+		postKeys();
+#ifdef KEYPAD_POLLED
+	if (ThisEvent.EventType == ES_INIT)
+	{
+		// sample from now on
+		Ctx.Scanning = true;
+		ES_Timer_InitTimer(KEYPAD_TIMER, KEYPAD_SCAN_TICKS);
+	}
+#else
+	if (ThisEvent.EventType == ES_INIT)
+	{
+		// a key held from power on made no edge
+		listenForKeys();
+	}
+	if ((ThisEvent.EventType == KEYPAD_ROW_EDGE) && !Ctx.Scanning)
+	{
+		// a key went down, sample until all keys are up again
+		Ctx.Scanning = true;
+		sampleKeys();
+		ES_Timer_InitTimer(KEYPAD_TIMER, KEYPAD_SCAN_TICKS);
+	}
+#endif
 	if ((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == KEYPAD_TIMER))
 	{
-		uint8_t num = findNum(); // detect which key pad button was pressed
-		if(num == 12){ // 'Enter' is pressed
-			if(sizeOfInput != 0){ 
-				
-				printf("Checking if password ");
-				printf(" is correct...\n\r");
-				if (checkPassword(passwordInput)) {
-					ES_Event ThisEvent;
-					ThisEvent.EventType = CORRECT_PASSWORD_ENTERED ;
-					PostDisarmFSM( ThisEvent );
-				} else {
-					ES_Event ThisEvent;
-					ThisEvent.EventType = INCORRECT_PASSWORD_ENTERED ;
-					PostDisarmFSM( ThisEvent );
-				}
-				sizeOfInput = 0;
-			}
-		} else if(sizeOfInput >= (MAX_PASS_SIZE)){ // reached limit of password length
-			if(num < 12) {
-				for (int i = 1; i < MAX_PASS_SIZE; i ++) {
-					passwordInput[i-1] = passwordInput[i];
-				}
-				passwordInput[MAX_PASS_SIZE - 1] = num;
-			}
-		}else if(num < 12){ // valid input
-				passwordInput[sizeOfInput] = num;
-				sizeOfInput++;
-		}else{
+#ifdef KEYPAD_POLLED
+		sampleKeys();
+		ES_Timer_InitTimer(KEYPAD_TIMER, KEYPAD_SCAN_TICKS);
+#else
+		if (!sampleKeys())
+		{
+			// every key is up and settled, go back to waiting for an edge
+			listenForKeys();
+		}
+		else
+		{
+			ES_Timer_InitTimer(KEYPAD_TIMER, KEYPAD_SCAN_TICKS);
+		}
+#endif
+	}
+	if (ThisEvent.EventType == KEYPAD_KEYS)
+	{
+		// take every key queued since, in the order they came
+		while (Ctx.FifoTail != Ctx.FifoHead)
+		{
+			KeyRecord_t Record = Ctx.Fifo[FIFO_INDEX(Ctx.FifoTail)];
+			Ctx.FifoTail++;
+			
+			// a key going up needs nothing here
+			if (Record.Down && !takeKey(Record.Key))
 				ReturnEvent.EventType = ES_ERROR;
 		}
 	}
@@ -216,38 +246,96 @@ ES_Event RunKeyPadFSM( ES_Event ThisEvent )
 ****************************************************************************/
 KeyPadFSMState_t QueryKeyPadFSM ( void )
 {
-   return(CurrentState);
+   return(Ctx.CurrentState);
+}
+
+/****************************************************************************
+ Function
+     PutKeyPadKey
+
+ Parameters
+     uint8_t : the key, (row-1)*3 + (col-1)
+		 bool : true if it went down, false if it went up
+
+ Returns
+     bool, false if the FIFO is full and the key was dropped
+
+ Description
+     Puts the key into the FIFO with the time now, and posts KEYPAD_KEYS
+		 if the FIFO was empty or the last post failed; otherwise RunKeyPadFSM
+		 has not taken the keys before this one yet and will take this one
+		 with them. The key is recorded in the event trace as a stimulus
+		 either way
+ Notes
+     the only writer of FifoHead; must not be interrupted by RunKeyPadFSM
+****************************************************************************/
+bool PutKeyPadKey(uint8_t Key, bool Down)
+{
+	uint8_t Head = Ctx.FifoHead;
+	uint8_t Queued = Head - Ctx.FifoTail;
+	ES_Event ThisEvent;
+	
+	ThisEvent.EventType = KEYPAD_KEYS;
+	ThisEvent.EventParam = Key | (Down ? KEYPAD_KEY_DOWN : 0);
+	EventTrace_RecordStimulus(Ctx.MyPriority, ThisEvent, EVENT_TRACE_TICK());
+	
+	if (Queued >= KEYPAD_FIFO_SIZE)
+	{
+		Ctx.FifoLost++;
+		return false;
+	}
+	
+	KeyRecord_t *pRecord = &Ctx.Fifo[FIFO_INDEX(Head)];
+	pRecord->Key = Key;
+	pRecord->Down = Down;
+	pRecord->Time = ES_Timer_GetTime();
+	// only now the reader may see it
+	Ctx.FifoHead = Head + 1;
+	
+	if ((Queued == 0) || Ctx.PostPending)
+		postKeys();
+	return true;
 }
 
 /*
- * Function reads rows and colums of Keypad and
- * returns number of button pressed on KeyPad
+ * The key pad is sampled on the KEYPAD_TIMER (see KeyPadFSM.h), so there
+ * is nothing left to check here; returns false without touching the pins.
  */
 bool CheckForKeyPadButtonPress(void)
 {
-	for (int r = 1; r <= NUM_ROWS ; r++){
-		for (int c = 1; c <= NUM_COLS; c++){
-			setColsHigh();
-			
-			setCol(c,0); // set column in question to Low
-			uint8_t thisRow = readRow(r);
-				if (thisRow && (prevButtonState != 1) && (prevButtonState != 255))
-				{
-					// One of the key pad buttons was pressed. 
-					// Post Event ButtonPressed after time-out.
-					Row = r;
-					Col = c;
-					ES_Timer_InitTimer(KEYPAD_TIMER, KEYPAD_TIMER_DELAY);
-					
-					prevButtonState = thisRow;;
-					return true;
-				}
-		}
-	}
-	prevButtonState = 0;
 	return false;
 }
 
+/****************************************************************************
+ Function
+     KeyPadRowISR
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     GPIO Port D interrupt response: one or more rows were pulled LO by a
+		 key while all columns are LO. Masks the rows, so that the bounce
+		 does not interrupt again, and posts KEYPAD_ROW_EDGE with the rows
+		 that fell for RunKeyPadFSM to start sampling
+ Notes
+     must be in the GPIO Port D slot of the vector table; the rows are
+		 unmasked again by enableRowInterrupts once all keys are up
+****************************************************************************/
+void KeyPadRowISR(void)
+{
+	uint8_t Rows = HWREG(GPIO_PORTD_BASE+GPIO_O_MIS) & ROW_PINS;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_IM) &= ~ROW_PINS;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_ICR) = Rows;
+	
+	ES_Event ThisEvent;
+	ThisEvent.EventType = KEYPAD_ROW_EDGE;
+	ThisEvent.EventParam = Rows;
+	PostKeyPadFSM(ThisEvent);
+}
 /***************************************************************************
  private functions
  ***************************************************************************/
@@ -269,6 +357,7 @@ bool CheckForKeyPadButtonPress(void)
 void InitKeyPadPortLines(void)
 {
 	PortFunctionInit(); // set PA2-5, PB2-3, PD7, PF0 to GPIO
+	initCycleCounter(); // for delayShort
 		
 	// wait a few	clock cycles
 	uint8_t pause = HWREG(SYSCTL_RCGCGPIO); 
@@ -303,94 +392,170 @@ void InitKeyPadPortLines(void)
 	HWREG(GPIO_PORTB_BASE+GPIO_O_DIR) |= ((GPIO_PIN_1)|(GPIO_PIN_0));// set Port B pins 0,1 to output
 	HWREG(GPIO_PORTE_BASE+GPIO_O_DIR) |= (GPIO_PIN_4);// set Port E pin 4 to output
 
-	setColsHigh();
+	// all columns LO, so that any key takes its row LO
+	setCols(0);
+
+#ifndef KEYPAD_POLLED
+	// pull the rows up, so that only a key can take one LO
+	HWREG(GPIO_PORTD_BASE+GPIO_O_PUR) |= ROW_PINS;
+	
+	// interrupt on the falling edge of a row
+	HWREG(GPIO_PORTD_BASE+GPIO_O_IS) &= ~ROW_PINS;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_IBE) &= ~ROW_PINS;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_IEV) &= ~ROW_PINS;
+	
+	// GPIO Port D is interrupt 19, bit 3 in EN0
+	HWREG(NVIC_EN0) = BIT3HI;
+	enableRowInterrupts();
+#endif
 
 	printf("Done Initializing KeyPad Port Lines\n\r");
 }
 
 /*
  *  *** EDIT HERE FOR SPECIFIC PIN ASSIGNMENTS **
- * Set Column High or Low
+ * Drive the columns: bit 0 of High for column 1 and so on, 1 = HI.
+ * One write per port through the masked data address, so no read back.
  */
-void setCol(int c, int dir) // sets column C as HI (dir ==1) or Lo.
+void setCols(uint8_t High)
 {
-	switch(c)
-	{
-		case 1: // column 1
-			if (dir == 1)
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) |= (GPIO_PIN_0);
-			else 
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) &= ~(GPIO_PIN_0);
-			break;
-		
-		case 2: // column 2
-			if (dir == 1)
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) |= (GPIO_PIN_1);
-			else
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) &= ~(GPIO_PIN_1);
-			break;
-			
-		case 3: // column 3
-			if (dir == 1)
-				HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) |= (GPIO_PIN_4);
-			else
-				HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) &= ~(GPIO_PIN_4);
-			break;
-			
-		default:
-			break;
-	}
+	HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + (COL_PINS_B<<2))) = High & COL_PINS_B; // columns 1,2 on PB0,1
+	HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + (COL_PIN_E<<2))) = (High & BIT2HI) ? COL_PIN_E : 0; // column 3 on PE4
 }
 
 /*
  *  *** EDIT HERE FOR SPECIFIC PIN ASSIGNMENTS **
- * Read state of a row
- * eg. calling row(1) returns 1 if the first row
- * sees a button press, 0 otherwise.
- *
+ * Read the whole key pad: takes one column LO at a time and reads all four
+ * rows at once. Returns bit (row-1)*NUM_COLS + (col-1) set for each key
+ * that is down (its row reads LO), and leaves all columns LO.
  */
-uint8_t readRow(int r)
+uint16_t scanMatrix(void)
 {
-	switch (r)
-	{
-		case 1: // row 1
-			if ((HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) &= (GPIO_PIN_0)) == 0) 
-				return 1;
-			else 
-				return 0;
-	
-		case 2: // row 2
-			if ((HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) &= (GPIO_PIN_1)) == 0)
-				return 1;
-			else 
-				return 0;
-	
-		case 3: // row 3
-			if ((HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) &= (GPIO_PIN_2)) == 0)
-				return 1;
-			else 
-				return 0;
+	uint16_t Down = 0;
 	
-		case 4: // row 4 
-			if ((HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) &= (GPIO_PIN_3)) == 0)
-				return 1;
-			else 
-				return 0;
+	for (int c = 0; c < NUM_COLS; c++)
+	{
+		setCols(ALL_COLS & ~(1<<c)); // set column in question to Low
+		uint8_t Rows = ~HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + (ROW_PINS<<2))) & ROW_PINS;
+		for (int r = 0; r < NUM_ROWS; r++)
+		{
+			if (Rows & (GPIO_PIN_0 << r))
+				Down |= 1 << (r*NUM_COLS + c);
+		}
+	}
+	setCols(0);
+	return Down;
+}
+
+/*
+ * Take one sample of the key pad and run each key's integrating
+ * debouncer on it, putting every key that changes into the FIFO. Returns false once every key is up and settled.
+ */
+bool sampleKeys(void)
+{
+	uint16_t Down = scanMatrix();
+	bool Active = false;
 	
-		default:
-			return 0;
+	for (uint8_t Key = 0; Key < NUM_KEYS; Key++)
+	{
+		uint16_t Bit = 1 << Key;
+		if (Down & Bit)
+		{
+			if (Ctx.Integrator[Key] < KEYPAD_DEBOUNCE_SAMPLES)
+				Ctx.Integrator[Key]++;
+			if ((Ctx.Integrator[Key] == KEYPAD_DEBOUNCE_SAMPLES) && !(Ctx.Keys & Bit))
+			{
+				Ctx.Keys |= Bit;
+				PutKeyPadKey(Key, true);
+			}
+		}
+		else
+		{
+			if (Ctx.Integrator[Key] > 0)
+				Ctx.Integrator[Key]--;
+			if ((Ctx.Integrator[Key] == 0) && (Ctx.Keys & Bit))
+			{
+				Ctx.Keys &= ~Bit;
+				PutKeyPadKey(Key, false);
+			}
+		}
+		if (Ctx.Integrator[Key] != 0)
+			Active = true;
 	}
+	return Active;
 }
- 
+
 /*
- * Function takes a Row and Column 
+ * Take one key pressed: a digit moves the password automaton on, Enter
+ * checks where it got to. Returns false for a key that is not on the pad.
+ */
+bool takeKey(uint8_t Key)
+{
+	uint8_t num = findNum(Key); // which key pad button was pressed
+	if(num == 12){ // 'Enter' is pressed
+		if(Ctx.sizeOfInput != 0){ 
+			
+			printf("Checking if password ");
+			printf(" is correct...\n\r");
+			postPasswordResult(checkPasswordState(Ctx.Match));
+		}
+		return true;
+	}else if(num < 10){ // a digit
+		Ctx.Match = advancePassword(Ctx.Match, num);
+	}else if(num == 10){ // '*' is in no password
+		Ctx.Match = PASSWORD_START;
+	}else{
+		return false;
+	}
+	if(Ctx.sizeOfInput < MAX_PASS_SIZE)
+		Ctx.sizeOfInput++;
+#ifdef KEYPAD_NO_ENTER
+	// one of the passcodes on show has been typed, that is the guess
+	if(matchPasswords(Ctx.Match) != 0)
+		postPasswordResult(checkPasswordState(Ctx.Match));
+#endif
+	return true;
+}
+
+/*
+ * Post KEYPAD_KEYS for the keys in the FIFO. A post that finds the queue
+ * full is left pending, and the next key put, or the next event this
+ * service runs, posts it again.
+ */
+void postKeys(void)
+{
+	ES_Event ThisEvent;
+	ThisEvent.EventType = KEYPAD_KEYS;
+	ThisEvent.EventParam = 0;
+	Ctx.PostPending = !PostKeyPadFSM(ThisEvent);
+}
+
+/*
+ * Tell DisarmFSM whether the password typed was the correct one, and start
+ * the input over.
+ */
+void postPasswordResult(bool Correct)
+{
+	ES_Event ThisEvent;
+	if (Correct)
+		ThisEvent.EventType = CORRECT_PASSWORD_ENTERED ;
+	else
+		ThisEvent.EventType = INCORRECT_PASSWORD_ENTERED ;
+	PostDisarmFSM( ThisEvent );
+	
+	Ctx.Match = PASSWORD_START;
+	Ctx.sizeOfInput = 0;
+}
+
+/*
+ * Function takes a key number, (row-1)*NUM_COLS + (col-1),
  * and returns the value of the number at the 
  * intersection of that row and column, 
  * assuming a 4-row x 3-column keypad layout.
  */
-uint8_t findNum(void)
+uint8_t findNum(uint8_t Key)
 {
-	uint8_t num = (Row-1)*NUM_COLS + Col;
+	uint8_t num = Key + 1;
 		if (num == 11)
 			return 0;
 		else if ((num >= 1) && (num <= 12))
@@ -399,28 +564,49 @@ uint8_t findNum(void)
 			return 255;
 }
 
-/* 
- * Set all columns high
+/*
+ * Listen for the next key: forget the edges seen while the rows were
+ * masked (the scan itself makes some) and unmask the rows. A key that
+ * went down just before made its edge while the rows were masked, so the
+ * rows are read once they are unmasked; if one is LO already they are
+ * masked again and it returns false, and the caller has to sample.
+ */
+bool enableRowInterrupts(void)
+{
+	HWREG(GPIO_PORTD_BASE+GPIO_O_ICR) = ROW_PINS;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_IM) |= ROW_PINS;
+	
+	if ((HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + (ROW_PINS<<2))) & ROW_PINS) == ROW_PINS)
+		return true;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_IM) &= ~ROW_PINS;
+	HWREG(GPIO_PORTD_BASE+GPIO_O_ICR) = ROW_PINS;
+	return false;
+}
+
+/*
+ * Stop sampling and wait for a row to fall, or, if a row is LO already,
+ * post KEYPAD_ROW_EDGE as KeyPadRowISR would so that sampling starts over.
+ * If the interrupt got in first, the second edge finds Scanning set and
+ * is ignored.
  */
-void setColsHigh() // setting all columns HI
+void listenForKeys(void)
 {
-	for (int c = 1 ; c  <=NUM_COLS; c++)
+	Ctx.Scanning = false;
+	if (!enableRowInterrupts())
 	{
-		setCol(c, 1);
+		ES_Event ThisEvent;
+		ThisEvent.EventType = KEYPAD_ROW_EDGE;
+		ThisEvent.EventParam = ROW_PINS;
+		PostKeyPadFSM(ThisEvent);
 	}
 }
 
 /*
- * Pause number of microseconds (us).
- * Will pause a little longer than input time.
+ * Pause number of microseconds (us), counted on the cycle counter.
  */
 void delayShort(uint16_t delayTime)
 {
-	uint16_t scaledTime = delayTime*SCALE_DELAY;
-	for(int i=0; i<scaledTime; i++)
-	{
-		uint8_t pause = HWREG(SYSCTL_RCGCGPIO);
-	}
+	delayUs(delayTime);
 }
 
 /*
@@ -443,12 +629,8 @@ void delayLong(uint16_t delayTime)
 void printCurrentInput(void)
 {
 	// for debugging *******************
-			printf("Current Input: [");
-			for(int i=0; i<sizeOfInput; i++) 
-			{
-			printf("%i ", passwordInput[i]);
-			}
-			printf("]\n\r");
+			printf("Current Input: %i keys, ends password(s) 0x%x\n\r",
+					Ctx.sizeOfInput, matchPasswords(Ctx.Match));
 }
 
 /***************************************************************************
@@ -457,6 +639,56 @@ void printCurrentInput(void)
 #ifdef TEST 
 /* test Harness for testing this module */ 
 #include "termio.h" 
+#ifdef HOST_SIM
+#include "HostSim.h"
+#include "HostHAL.h"
+
+/* on the host: types the digit 1 while the service's queue is full, so
+   that its KEYPAD_KEYS post fails, and checks the key is still taken;
+   then types 2 and checks that keys go on being taken */
+int main(void)
+{
+	ES_Event ThisEvent;
+
+	TERMIO_Init();
+	HostSim_SetRealTime(false);
+	printf("\n\rIn Test Harness for KeyPadFSM\r\n");
+	HostHAL_Reset();
+	HostSim_ResetClock();
+	GameContext_Init(pGame);
+	if (ES_Initialize(ES_Timer_RATE_1mS) != Success) {
+		printf("Failed Initialization\r\n");
+		return 1;
+	}
+	HostSim_RunUntil(100);
+
+	// fill the queue
+	ThisEvent.EventType = ES_NO_EVENT;
+	ThisEvent.EventParam = 0;
+	while (PostKeyPadFSM(ThisEvent))
+		;
+	PutKeyPadKey(0, true);
+	if (!Ctx.PostPending) {
+		printf("FAIL: the post into a full queue was not left pending\r\n");
+		return 1;
+	}
+	HostSim_RunUntil(HostSim_GetTicks() + 100);
+	if ((Ctx.FifoTail != Ctx.FifoHead) || (Ctx.sizeOfInput != 1)) {
+		printf("FAIL: the key whose post failed was not taken\r\n");
+		return 1;
+	}
+
+	PutKeyPadKey(0, false);
+	PutKeyPadKey(1, true);
+	HostSim_RunUntil(HostSim_GetTicks() + 100);
+	if (Ctx.PostPending || (Ctx.FifoTail != Ctx.FifoHead) || (Ctx.sizeOfInput != 2)) {
+		printf("FAIL: the keys after it were not taken\r\n");
+		return 1;
+	}
+	printf("PASS: a key whose KEYPAD_KEYS post failed is still taken\r\n");
+	return 0;
+}
+#else
 int main(void) 
 { 
 	// Set the clock to run at 40MhZ using the PLL and 16MHz external crystal
@@ -476,6 +708,7 @@ int main(void)
 	// Your hardware initialization function calls go here
 
 	//LCDInit(); // INITIALIZE LCD FOR TESTING
+	GameContext_Init(pGame);
 	
 	// now initialize the Events and Services Framework and start it running
 	ErrorType = ES_Initialize(ES_Timer_RATE_1mS);
@@ -504,3 +737,4 @@ int main(void)
 	return 0; 
 } 
 #endif 
+#endif 
@@ -11,11 +11,85 @@
 // Event Definitions
 #include "ES_Configure.h" /* gets us event definitions */
 #include "ES_Types.h"     /* gets bool type for returns */
+#include "passwordGenerator.h"
+
+/* NOTES:
+
+	The key pad wakes the CPU up itself. While no key is down all three
+	columns are driven LO, and a key pulling its row LO interrupts on that
+	falling edge. KeyPadRowISR masks the row interrupts and posts
+	KEYPAD_ROW_EDGE, and the state machine starts sampling the key pad
+	every KEYPAD_SCAN_TICKS on the KEYPAD_TIMER. Once every key has been
+	seen up for long enough the sampling stops and the rows are unmasked
+	again; a key that went down just before makes no edge then, so the
+	rows are read once unmasked and one that is LO starts the sampling
+	over at once (this also catches a key held from power on). An idle key pad costs no CPU at all, and
+	CheckForKeyPadButtonPress returns false at once, so it can come off
+	EVENT_CHECK_LIST.
+
+	A sample takes the whole matrix at once as a 12 bit mask, bit
+	(row-1)*3 + (col-1) set for a key that is down: one column LO at a
+	time, one read of the four rows each. Every key has its own integrating
+	debouncer, counting up while the key reads down and down while it
+	reads up; it is taken as pressed when the count reaches
+	KEYPAD_DEBOUNCE_SAMPLES and as released when it gets back to 0, so a
+	key pressed while another is still held is not lost (rollover).
+
+	Each change goes into a FIFO of KeyRecord_t, the key, whether it went
+	down or up, and the ES_Timer_GetTime tick it settled on. Putting a key
+	into an empty FIFO posts KEYPAD_KEYS, and RunKeyPadFSM then takes every
+	key queued, in order, however many came in before it ran. The FIFO has
+	one writer (the sampler, or PutKeyPadKey) and one reader and needs no
+	critical section, as long as the writer is never interrupted by the
+	reader: from an interrupt or from this service is fine. A key that
+	finds the FIFO full is dropped and counted in FifoLost. If the
+	KEYPAD_KEYS post finds the service's queue full, the next key put, or
+	the next event RunKeyPadFSM runs (the queue was full of them), posts
+	it again, so the keys already queued are still taken.
+
+	Every key put into the FIFO is also recorded in the event trace as a
+	stimulus (see EventTrace.h), so a replay can put it in again with
+	PutKeyPadKey.
+
+	Digits are not kept: each one moves the password automaton of
+	passwordGenerator.c on, and Enter asks it whether the last digits are
+	the correct password. '*' starts the automaton over. Define
+	KEYPAD_NO_ENTER to take a guess as soon as the digits spell one of the
+	four passcodes on show, without waiting for Enter.
+
+	Define KEYPAD_POLLED for the whole project to leave the row interrupt
+	off and sample all the time instead.
+
+	Make sure to edit 'ES_Configure.h': add KEYPAD_ROW_EDGE and
+	KEYPAD_KEYS to ES_EventTyp_t. And put KeyPadRowISR in the GPIO Port D
+	slot (interrupt 19) of the vector table in the startup file.
+*/
+
+// longest password that can be typed in
+#define MAX_PASS_SIZE MAX_PASS_LENGTH
+
+// keys on the pad, 4 rows of 3
+#define NUM_KEYS 12
+// ticks between two samples of the key pad
+#define KEYPAD_SCAN_TICKS 2
+// samples a key must read the same before it counts as pressed or released
+#define KEYPAD_DEBOUNCE_SAMPLES 4
+// keys the FIFO holds, a power of 2 no bigger than 128
+#define KEYPAD_FIFO_SIZE 16
+// set in the EventParam of a traced key that went down
+#define KEYPAD_KEY_DOWN 0x80
 
 // typedefs for the states
 // State definitions for use with the query function
  typedef enum { InitPState, ButtonPressed } KeyPadFSMState_t ;
 
+// one key going down or up, as kept in the FIFO
+typedef struct {
+	uint8_t Key; // (row-1)*3 + (col-1)
+	bool Down; // true when pressed, false when let go
+	uint16_t Time; // ES_Timer_GetTime when the debouncer settled
+} KeyRecord_t;
+
 // Public Function Prototypes
 // Checks whether any key pad button was pressed
 bool CheckForKeyPadButtonPress( void );
@@ -33,6 +107,13 @@ ES_Event RunKeyPadFSM( ES_Event ThisEvent );
 // Returns the current state of the KeyPadFSM state machine
 KeyPadFSMState_t QueryKeyPadFSM ( void );
 
+// GPIO Port D interrupt: a row went LO
+void KeyPadRowISR( void );
+
+// queues a key going down or up for RunKeyPadFSM, the way the sampler
+// does; false if the FIFO is full
+bool PutKeyPadKey( uint8_t Key, bool Down );
+
 
 #endif /* KEYPAD_FSM_H */
 
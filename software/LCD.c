@@ -9,26 +9,43 @@
 	 It sends all the information (like RS, D0, etc. pins), pulses the shift 
 	 register to send to the LCD, then pulses the shift reigster again, 
 	 in quick succession with E being set low and hi.
+
+	 After LCDInit, writing to the LCD only changes a copy of the display in
+	 memory and returns. The LCD service queues the cells that differ from
+	 what the LCD shows, takes one nibble off the queue every tick of
+	 LCD_TIMER and sends it, so the rest of the game keeps running while
+	 text is being written.
+
+	 Built with LCD_SSI defined, SSI0 clocks the shift register instead of
+	 port C being bit-banged, and the LCD service hands the whole queue to
+	 uDMA in one transfer. The LCD.h functions stay the same.
 ****************************************************************************/
 //#define TEST
 
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_gpio.h"
 #include "inc/hw_sysctl.h"
 #include "driverlib/sysctl.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
 #include "ES_Port.h"
 #include "ES_Timers.h"
 #include "termio.h"
 #include "LCD.h"
 #include "passwordGenerator.h" // random passcode gets called
 #include "driverlib/gpio.h"
-
-#define ALL_BITS (0xff <<2)
+#include "GameContext.h"
+#include "ShiftBus.h"
+#ifdef LCD_SSI
+#include "inc/hw_ssi.h"
+#include "inc/hw_udma.h"
+#endif
 
 /* definitions for array bit numbers
 	 Basically E_HI will set the bit connected to E HI
@@ -51,6 +68,35 @@
 
 #define BIT(x) (1<<(x))
 
+#define LCD_TICKS 1 // ticks between nibbles, enough for 37 uS
+
+/* the shift register images of every byte, worked out by the compiler:
+	 the nibble's bits 0-3 go to D4-D7, which are bits 7-4 of the image, and
+	 each byte gets its upper nibble's image first, with RS HI for a letter
+*/
+#define NIBBLE_IMAGE(n) ((((n) & BIT0HI) ? D4_HI : 0) | (((n) & BIT1HI) ? D5_HI : 0) | \
+		(((n) & BIT2HI) ? D6_HI : 0) | (((n) & BIT3HI) ? D7_HI : 0))
+#define IMAGES(b) { NIBBLE_IMAGE((b) >> 4) | RS_HI, NIBBLE_IMAGE((b) & 0x0F) | RS_HI }
+#define IMAGES4(b) IMAGES(b), IMAGES((b) + 1), IMAGES((b) + 2), IMAGES((b) + 3)
+#define IMAGES16(b) IMAGES4(b), IMAGES4((b) + 4), IMAGES4((b) + 8), IMAGES4((b) + 12)
+#define IMAGES64(b) IMAGES16(b), IMAGES16((b) + 16), IMAGES16((b) + 32), IMAGES16((b) + 48)
+
+#define SET_DDRAM 0x80 // instruction to set the DDRAM address
+#define SECOND_LINE 0x40 // DDRAM address of the second line
+#define ADDRESS_UNKNOWN 0xFF // the LCD's address is somewhere in CGRAM
+
+/* the countdown bar: the second line is 16 cells of 5 dots each. Full
+	 cells use the all-dots character from the LCD's ROM, the cell at the end
+	 of the bar one of four glyphs 1 to 4 dots wide, loaded into CGRAM as
+	 characters 1 to 4 (character 0 would end a string)
+*/
+#define SET_CGRAM 0x40 // instruction to set the CGRAM address
+#define FULL_BLOCK ((char)0xFF)
+#define GLYPH_ROWS 8
+#define DOTS_PER_CELL 5
+#define BAR_LINE 1
+#define BAR_DOTS (LCD_COLUMNS * DOTS_PER_CELL)
+
 //the order goes: LCD = D4-D5-D6-D7-RS-RW-E-empty
 //on the shift register: QB-QC-QD-QE-QF-QG-QH
 //bit numbering goes:7-6-5-4-3-2-1-0
@@ -65,17 +111,71 @@
 #define LCD_SCK GPIO_PIN_5 // pin 5
 #define LCD_RCK GPIO_PIN_6 // pin 6
 
-/* Module level variables */
-char LCD;
-static uint8_t messageNumber = 0;
+#ifdef LCD_SSI
+/****************************************************************************
+  With LCD_SSI, the shift register is on SSI0 instead: PA5 (SSI0Tx) to its
+	data, PA2 (SSI0Clk) to SCK and PA3 (SSI0Fss) to RCK. Between frames Fss
+	goes HI for one clock, and that edge latches the byte. PA2 and PA3 are
+	the LED shift register's data and SCK otherwise, so in this build
+	LEDs.c moves them to PA6 and PA7.
+****************************************************************************/
+#define LCD_SSI_PORT_DEC SYSCTL_RCGCGPIO_R0 //port A
+#define LCD_SSI_PORT GPIO_PORTA_BASE // port A base
+#define LCD_SSI_PINS (GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_5)
+// PA2, PA3 and PA5 all take function 2 (SSI0) in GPIOPCTL
+#define LCD_SSI_PCTL_M ((0xF << 8) | (0xF << 12) | (0xF << 20))
+#define LCD_SSI_PCTL ((2 << 8) | (2 << 12) | (2 << 20))
+
+// 40MHz / 40 = 1MHz, so a frame and its Fss pulse take 9 uS
+#define LCD_SSI_CPSR 40
+#define LCD_DMA_CHANNEL 11 // SSI0 TX, encoding 0
+
+#define FRAMES_PER_NIBBLE 3 // the nibble, with E HI, with E LO again
+// frames repeated after each byte: E falls, then GAP_FRAMES + 2 frames go
+// by before it can rise again, (3 + 2) * 9 uS is more than the 37 uS the
+// byte takes to execute
+#define GAP_FRAMES 3
+#define FRAMES_SIZE ((LCD_QUEUE_SIZE / 2) * (2 * FRAMES_PER_NIBBLE + GAP_FRAMES))
+#endif
 
-/* Prviate Function Prototypes */
+/* Module level variables */
+// the shift register byte, the message number, the queue of nibbles and the
+// copy of the display are kept in LCDContext_t (see GameContext.h)
+#define Ctx (pGame->LCD)
+
+// the text of every message, in flash; LCDwriteLine cuts the ones longer
+// than a line
+static const char * const Messages[NumLCDMessages] = {
+	"Welcome DrEd", // WelcomeMessage
+	"Passcodes:", // PasscodesMessage
+	"Authorized!", // AuthorizedMessage
+	"Your Time Is Up!", // TimeUpMessage
+	"Incorrect Password", // IncorrectMessage
+	"Armed", // ArmedMessage
+};
+
+#ifndef LCD_SSI
+// the shift register, one 595 with D4 on its first output
+static const ShiftBus_t LCDBus = {
+	LCD_PORT, LCD_PORT_DEC, LCD_DATA, LCD_SCK, LCD_RCK, 1, true
+};
+#endif
 
-// transfer bit to shift register
-void SCKPulseLCD (void); 
+// the two images of each letter, upper nibble first; instructions are the
+// same with RS LO
+static const uint8_t LetterImages[256][2] = {
+	IMAGES64(0), IMAGES64(64), IMAGES64(128), IMAGES64(192)
+};
+
+#ifdef LCD_SSI
+// the uDMA control table (primary structures only, which uDMA wants on a
+// 1024 byte boundary) and the frames it sends belong to the chip, not to a
+// station, so they are not in LCDContext_t
+static uint32_t DMAControlTable[32 * 4] __attribute__((aligned(1024)));
+static uint8_t Frames[FRAMES_SIZE];
+#endif
 
-// transfers 8 bits to the world
-void RCKPulseLCD (void); 
+/* Prviate Function Prototypes */
 
 // sends an 8 bit input to shift register - doesn't pulse LCD pin E
 void sendToShiftReg (char Data);
@@ -83,64 +183,185 @@ void sendToShiftReg (char Data);
 // takes 8 bit input and pulses E to input into LCD, uses the sendToShiftReg function
 void sendToLCD (char Data); 
 
-// using the sendToLCD function, it writes a specific letter to the LCD
+// writes a specific letter into the copy of the display
 void LCDputchar (char letter);
+
+// puts the two nibbles of an instruction (RS LO) or a letter (RS HI) in the queue
+void queueLCDByte (uint8_t Value, bool Data);
+
+// puts one shift register byte (data lines and RS) at the end of the queue
+void queueLCDNibble (uint8_t Nibble);
+
+#ifndef LCD_SSI
+// pulses E for a nibble that is already on the data lines and RS
+void sendNibbleToLCD (uint8_t Nibble);
+#endif
+
+// starts LCD_TIMER unless the LCD service is already running it
+void startLCDService (void);
+
+// queues what it takes to make the LCD show the copy of the display
+void queueChanges (void);
+
+// writes digits as text, and a terminator
+void renderDigits (char *pDest, const uint8_t *pDigits, uint8_t Count);
+
+// queues the countdown bar's glyphs into CGRAM
+void queueGlyphs (void);
+
+// draws the countdown bar with the time left, and sets up the next update
+void updateCountdown (void);
+
+// draws a countdown bar Dots dots long into the copy of the display
+void drawBar (uint8_t Dots);
+
+#ifdef LCD_SSI
+// sets up SSI0 and its uDMA channel to drive the shift register
+void initSSI (void);
+
+// true until the last transfer has been clocked out
+bool isTransferBusy (void);
+
+// hands every nibble in the queue to uDMA as shift register frames
+void sendQueueToLCD (void);
+#endif
 /****************************************************************************
  Function
-     SCKPulseLCD
+     InitLCDService
 
  Parameters
-     none
+     uint8_t : the priority of this service
 
  Returns
-     none
+     bool, false if error in initialization, true otherwise
 
  Description
-     pulses the pin connected the SCK by writing it HI, then back to LO again
+     Saves away the priority, and posts the initial transition event
+ Notes
+		 the LCD itself is set up by LCDInit, called from InitDisarmFSM
+****************************************************************************/
+bool InitLCDService (uint8_t Priority) {
+	ES_Event ThisEvent;
+
+	Ctx.MyPriority = Priority;
+
+	// post the initial transition event
+	ThisEvent.EventType = ES_INIT;
+	return ES_PostToService(Ctx.MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostLCDService
+
+ Parameters
+     ES_Event ThisEvent ,the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
  Notes
 
 ****************************************************************************/
-void SCKPulseLCD (void) {
-	// pulses SCK pin HI
-	HWREG(LCD_PORT+(GPIO_O_DATA + ALL_BITS)) |= LCD_SCK; 
-	
-	// kill time
-	for (int i = 1; i < 50; i ++){
-		HWREG(SYSCTL_RCGCGPIO);
+bool PostLCDService (ES_Event ThisEvent) {
+	return ES_PostToService(Ctx.MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     RunLCDService
+
+ Parameters
+     ES_Event : the event to process
+
+ Returns
+     ES_Event, ES_NO_EVENT
+
+ Description
+     on every LCD_TIMER timeout, sends the nibble at the front of the queue
+		 and starts the timer again for the next one. Once the queue is empty
+		 it queues the countdown glyphs if they have not been loaded yet, or
+		 else the cells that changed since, if any. The timer runs one more
+		 time after the last nibble, so a nibble queued later still waits for
+		 the last one to execute.
+
+		 on a COUNTDOWN_TIMER timeout, shortens the countdown bar
+ Notes
+		 In 'ES_Configure.h':
+			#define TIMER9_RESP_FUNC PostLCDService
+			#define TIMER10_RESP_FUNC PostLCDService
+			#define LCD_TIMER 9
+			#define COUNTDOWN_TIMER 10
+****************************************************************************/
+ES_Event RunLCDService (ES_Event ThisEvent) {
+	ES_Event ReturnEvent;
+	ReturnEvent.EventType = ES_NO_EVENT;
+
+	if (ThisEvent.EventType != ES_TIMEOUT)
+		return ReturnEvent;
+
+	if (ThisEvent.EventParam == COUNTDOWN_TIMER) {
+		updateCountdown();
+		return ReturnEvent;
 	}
-	
-	// pulses SCK pin LO
-	HWREG(LCD_PORT+(GPIO_O_DATA + ALL_BITS)) &= ~LCD_SCK; 
+
+	if (ThisEvent.EventParam != LCD_TIMER)
+		return ReturnEvent;
+
+	if ((Ctx.queueCount == 0) && !Ctx.glyphsLoaded)
+		queueGlyphs();
+	else if ((Ctx.queueCount == 0) && Ctx.dirty)
+		queueChanges();
+
+	if (Ctx.queueCount == 0) {
+		// the last nibble has had its time, the next one can start the timer
+		Ctx.draining = false;
+		return ReturnEvent;
+	}
+
+#ifdef LCD_SSI
+	// the whole queue goes at once, when the transfer before is done
+	if (!isTransferBusy())
+		sendQueueToLCD();
+#elif defined(HOST_FUZZ)
+	// nothing reads the LCD's pins in the fuzz build (see host/HostFuzz.h),
+	// so the whole queue is taken at once, without shifting it out
+	Ctx.LCD = Ctx.queue[(Ctx.queueHead + Ctx.queueCount - 1) % LCD_QUEUE_SIZE];
+	Ctx.queueHead = (Ctx.queueHead + Ctx.queueCount) % LCD_QUEUE_SIZE;
+	Ctx.queueCount = 0;
+#else
+	uint8_t nibble = Ctx.queue[Ctx.queueHead];
+	Ctx.queueHead = (Ctx.queueHead + 1) % LCD_QUEUE_SIZE;
+	Ctx.queueCount--;
+
+	sendNibbleToLCD(nibble);
+#endif
+	ES_Timer_InitTimer(LCD_TIMER, LCD_TICKS);
+	return ReturnEvent;
 }
 
 /****************************************************************************
  Function
-     RCKPulseLCD
+     isLCDBusy
 
  Parameters
      none
 
  Returns
-     none
+     bool : true while there are nibbles in the queue or cells to compare
 
  Description
-     pulses the pin connected the RCK by writing it HI, then back to LO again
+     tells whether everything written so far has reached the LCD
  Notes
 
 ****************************************************************************/
-void RCKPulseLCD (void) {
-	// pulses RCK pin HI
-	HWREG(LCD_PORT+(GPIO_O_DATA + ALL_BITS)) |= LCD_RCK; 
-	
-	// kill time
-	for (int i = 1; i < 50; i ++){
-		HWREG(SYSCTL_RCGCGPIO);
-	}
-	
-	// pulses RCK pin LO
-	HWREG(LCD_PORT+(GPIO_O_DATA + ALL_BITS)) &= ~LCD_RCK; 	
+bool isLCDBusy (void) {
+	return ((Ctx.queueCount > 0) || Ctx.dirty);
 }
 
+#ifndef LCD_SSI
 /****************************************************************************
  Function
      sendToShiftReg
@@ -159,28 +380,149 @@ void RCKPulseLCD (void) {
 		 this function is a PRIVATE function
 ****************************************************************************/
 void sendToShiftReg (char Data) {
-	char send = 0;
-	for (int i= 0; i <8; i ++) {
-		send = (!! ((Data << i) & (0x80))); //takes left most bit, and returns 1 if it is 1, and 0 if it is 0
-		if (send == 1){
-			HWREG(LCD_PORT + GPIO_O_DATA + ALL_BITS) |= LCD_DATA;
-		}
-		else if (send == 0) {
-			HWREG(LCD_PORT + GPIO_O_DATA + ALL_BITS) &= ~(LCD_DATA);
-		}
-		else { // for debugging only
-			//puts ("entered neither 1 nor 0");
-			//puts("\n\r sendToShiftReg send value not 0 or 1 \r\n");
+	uint8_t frame = (uint8_t)Data;
+	ShiftBusSend(&LCDBus, &frame, 1);
+}
+#else
+/****************************************************************************
+ Function
+     sendToShiftReg
+
+ Parameters
+     char
+
+ Returns
+     none
+
+ Description
+     sends the char as one SSI frame, and waits for Fss to latch it
+ Notes
+		 this function is a PRIVATE function, and only LCDInit uses it in this
+		 build; it waits for the LCD service's transfers to finish first
+****************************************************************************/
+void sendToShiftReg (char Data) {
+	while (isTransferBusy())
+		;
+	HWREG(SSI0_BASE + SSI_O_DR) = (uint8_t)Data;
+	while (HWREG(SSI0_BASE + SSI_O_SR) & SSI_SR_BSY)
+		;
+}
+
+/****************************************************************************
+ Function
+     initSSI
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     gives PA2, PA3 and PA5 to SSI0, sets it up as an 8 bit Freescale SPI
+		 master at 1MHz, and points uDMA channel 11 at its transmit FIFO
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void initSSI (void) {
+	HWREG(SYSCTL_RCGCGPIO) |= LCD_SSI_PORT_DEC;
+	HWREG(SYSCTL_RCGCSSI) |= SYSCTL_RCGCSSI_R0;
+	HWREG(SYSCTL_RCGCDMA) |= SYSCTL_RCGCDMA_R0;
+	while ((HWREG(SYSCTL_PRSSI) & SYSCTL_PRSSI_R0) == 0)
+		;
+
+	HWREG(LCD_SSI_PORT + GPIO_O_DEN) |= LCD_SSI_PINS;
+	HWREG(LCD_SSI_PORT + GPIO_O_AFSEL) |= LCD_SSI_PINS;
+	HWREG(LCD_SSI_PORT + GPIO_O_PCTL) =
+			(HWREG(LCD_SSI_PORT + GPIO_O_PCTL) & ~LCD_SSI_PCTL_M) | LCD_SSI_PCTL;
+
+	// SSI0 off while it is set up: master, system clock, SPO = SPH = 0 so
+	// Fss pulses HI between frames
+	HWREG(SSI0_BASE + SSI_O_CR1) = 0;
+	HWREG(SSI0_BASE + SSI_O_CC) = SSI_CC_CS_SYSPLL;
+	HWREG(SSI0_BASE + SSI_O_CPSR) = LCD_SSI_CPSR;
+	HWREG(SSI0_BASE + SSI_O_CR0) = SSI_CR0_FRF_MOTO | SSI_CR0_DSS_8;
+	HWREG(SSI0_BASE + SSI_O_DMACTL) = SSI_DMACTL_TXDMAE;
+	HWREG(SSI0_BASE + SSI_O_CR1) = SSI_CR1_SSE;
+
+	// uDMA on, channel 11 to SSI0 TX, primary structure, single requests too
+	HWREG(UDMA_CFG) = UDMA_CFG_MASTEN;
+	HWREG(UDMA_CTLBASE) = (uint32_t)DMAControlTable;
+	HWREG(UDMA_CHMAP1) &= ~UDMA_CHMAP1_CH11SEL_M;
+	HWREG(UDMA_ALTCLR) = BIT(LCD_DMA_CHANNEL);
+	HWREG(UDMA_USEBURSTCLR) = BIT(LCD_DMA_CHANNEL);
+	HWREG(UDMA_REQMASKCLR) = BIT(LCD_DMA_CHANNEL);
+}
+
+/****************************************************************************
+ Function
+     isTransferBusy
+
+ Parameters
+     none
+
+ Returns
+     bool : true while uDMA or SSI0 still have frames to send
+
+ Description
+     the channel disables itself when uDMA has moved the last frame, and
+		 SSI0 is busy until that frame has been clocked out
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+bool isTransferBusy (void) {
+	return ((HWREG(UDMA_ENASET) & BIT(LCD_DMA_CHANNEL)) ||
+			(HWREG(SSI0_BASE + SSI_O_SR) & SSI_SR_BSY));
+}
+
+/****************************************************************************
+ Function
+     sendQueueToLCD
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     empties the queue into Frames, three frames a nibble with E pulsed in
+		 the middle one and GAP_FRAMES more after every byte for it to
+		 execute, then starts a basic uDMA transfer of Frames into SSI0
+ Notes
+		 this function is a PRIVATE function
+		 the queue holds whole bytes, so every second nibble ends one
+****************************************************************************/
+void sendQueueToLCD (void) {
+	uint16_t count = 0;
+	uint32_t *pChannel = &DMAControlTable[LCD_DMA_CHANNEL * 4];
+
+	while (Ctx.queueCount > 0) {
+		uint8_t nibble = Ctx.queue[Ctx.queueHead];
+		Ctx.queueHead = (Ctx.queueHead + 1) % LCD_QUEUE_SIZE;
+		Ctx.queueCount--;
+
+		Ctx.LCD = nibble;
+		Frames[count++] = nibble;
+		Frames[count++] = nibble | E_HI;
+		Frames[count++] = nibble;
+		if ((Ctx.queueCount % 2) == 0) {
+			for (uint8_t i = 0; i < GAP_FRAMES; i++) {
+				Frames[count++] = nibble;
+			}
 		}
-		// pulses SCK to send the single bit to shift register
-		SCKPulseLCD();
 	}
-	
-	/* leaving the loop means it has gone through all 8 bits, so
-	   the shfit register is ready to write it to LCD
-	*/
-	RCKPulseLCD();
+
+	// source and destination end pointers, then the control word
+	pChannel[0] = (uint32_t)&Frames[count - 1];
+	pChannel[1] = SSI0_BASE + SSI_O_DR;
+	pChannel[2] = UDMA_CHCTL_DSTINC_NONE | UDMA_CHCTL_DSTSIZE_8 |
+			UDMA_CHCTL_SRCINC_8 | UDMA_CHCTL_SRCSIZE_8 | UDMA_CHCTL_ARBSIZE_4 |
+			((uint32_t)(count - 1) << UDMA_CHCTL_XFERSIZE_S) |
+			UDMA_CHCTL_XFERMODE_BASIC;
+	HWREG(UDMA_ENASET) = BIT(LCD_DMA_CHANNEL);
 }
+#endif
 
 /****************************************************************************
  Function
@@ -202,6 +544,10 @@ void sendToShiftReg (char Data) {
 		 isn't lost) and then writes E back LO. effectively, it is pulsing E so that
      the LCD sees what is being fed into it.
 
+		 the LCD latches the data when E falls, so E has to go back LO with the
+		 same data still on the pins; leaving it HI until the next call made it
+		 fall together with the next nibble
+
 		 this function is also a PRIVATE function
 ****************************************************************************/
 void sendToLCD (char Data) {
@@ -210,6 +556,149 @@ void sendToLCD (char Data) {
 	sendToShiftReg(Data);
 	wait(1);
 	Data &= E_LO;
+	sendToShiftReg(Data);
+}
+
+#ifndef LCD_SSI
+/****************************************************************************
+ Function
+     sendNibbleToLCD
+
+ Parameters
+     uint8_t : data lines and RS, as for sendToLCD
+
+ Returns
+     none
+
+ Description
+     pulses E HI and back LO around the nibble without waiting, as one
+		 transfer of three frames; the LCD service waits for the LCD between
+		 nibbles instead
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void sendNibbleToLCD (uint8_t Nibble) {
+	const uint8_t frames[3] = { Nibble, Nibble | E_HI, Nibble };
+
+	Ctx.LCD = Nibble;
+	ShiftBusSend(&LCDBus, frames, 3);
+}
+#endif
+
+/****************************************************************************
+ Function
+     queueLCDByte
+
+ Parameters
+     uint8_t : the instruction or letter
+		 bool : true for a letter (RS HI)
+
+ Returns
+     none
+
+ Description
+     looks up the byte's two nibbles, upper first, in the reversed
+		 D4-D5-D6-D7 order of the shift register, and queues them
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void queueLCDByte (uint8_t Value, bool Data) {
+	uint8_t rs = Data ? 0xFF : (uint8_t)RS_LO;
+	uint8_t upper = LetterImages[Value][0] & rs;
+	uint8_t lower = LetterImages[Value][1] & rs;
+
+	// the queue only ever holds whole bytes, so a full one drops this one
+	if (LCD_QUEUE_SIZE - Ctx.queueCount < 2)
+		return;
+
+	queueLCDNibble(upper);
+	queueLCDNibble(lower);
+}
+
+/****************************************************************************
+ Function
+     queueLCDNibble
+
+ Parameters
+     uint8_t : data lines and RS
+
+ Returns
+     none
+
+ Description
+     puts the nibble at the end of the queue, and starts LCD_TIMER if the
+		 LCD service is not already taking nibbles off it
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void queueLCDNibble (uint8_t Nibble) {
+	Ctx.queue[(Ctx.queueHead + Ctx.queueCount) % LCD_QUEUE_SIZE] = Nibble;
+	Ctx.queueCount++;
+	startLCDService();
+}
+
+/****************************************************************************
+ Function
+     startLCDService
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     starts LCD_TIMER, unless the LCD service is already running it for
+		 the nibbles before
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void startLCDService (void) {
+	if (!Ctx.draining) {
+		Ctx.draining = true;
+		ES_Timer_InitTimer(LCD_TIMER, LCD_TICKS);
+	}
+}
+
+/****************************************************************************
+ Function
+     queueChanges
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     compares the copy of the display with what has been queued for the LCD
+		 so far, and queues the letters of the cells that differ. A DDRAM
+		 address goes before a letter only when the LCD's address is not
+		 already on that cell, so a run of changed cells costs one address
+ Notes
+		 this function is a PRIVATE function
+		 only called with an empty queue, and the most it queues (every cell
+		 and an address per line) is what LCD_QUEUE_SIZE holds
+****************************************************************************/
+void queueChanges (void) {
+	for (uint8_t line = 0; line < LCD_LINES; line++) {
+		for (uint8_t column = 0; column < LCD_COLUMNS; column++) {
+			char letter = Ctx.frame[line][column];
+			uint8_t address = line * SECOND_LINE + column;
+
+			if (letter == Ctx.shown[line][column])
+				continue;
+
+			if (Ctx.address != address) {
+				queueLCDByte(SET_DDRAM | address, false);
+				Ctx.address = address;
+			}
+			queueLCDByte((uint8_t)letter, true);
+			Ctx.address++;
+			Ctx.shown[line][column] = letter;
+		}
+	}
+	Ctx.dirty = false;
 }
 
 /****************************************************************************
@@ -228,30 +717,43 @@ void sendToLCD (char Data) {
 
 ****************************************************************************/
 void LCDInit (void) {
-	/* LaunchPad init for ports C 4, 5 and 6 and 7*/
-	HWREG(SYSCTL_RCGCGPIO) |= LCD_PORT_DEC;
-	// kill time
-	HWREG(SYSCTL_RCGCGPIO);
-	//set C4-7 as outputs
-	HWREG(LCD_PORT + GPIO_O_DEN)|= (LCD_DATA | LCD_SCK | LCD_RCK);
-	HWREG(LCD_PORT + GPIO_O_DIR) |= (LCD_DATA | LCD_SCK | LCD_RCK);
+#ifdef LCD_SSI
+	initSSI();
+#else
+	/* LaunchPad init for ports C 4, 5 and 6 */
+	ShiftBusInit(&LCDBus);
+#endif
 	
 	/* initialize timer */
 	_HW_Timer_Init(ES_Timer_RATE_2mS);
 	
 	/*
 	 LCD Initialization begins
-	 Wait for more than 15 ms after VCC rises to 4.5 V
+	 Wait for more than 15 ms after VCC rises to 4.5 V (40 ms at 2.7 V),
+	 21 ticks is at least 40 mS however close the next tick is
 	 */
-	wait (110);
-	LCD = 0;
+	wait (21);
+	Ctx.LCD = 0;
+	Ctx.queueHead = 0;
+	Ctx.queueCount = 0;
+	Ctx.draining = false;
+	// the clear below leaves the LCD blank, with its address at the first cell
+	memset(Ctx.frame, ' ', sizeof(Ctx.frame));
+	memset(Ctx.shown, ' ', sizeof(Ctx.shown));
+	Ctx.dirty = false;
+	Ctx.line = 0;
+	Ctx.column = 0;
+	Ctx.address = 0;
+	// CGRAM is not cleared by the LCD, so the glyphs are loaded every time
+	Ctx.glyphsLoaded = false;
+	Ctx.countdownOn = false;
 	
 	// sends 000011 3 times, with at least 5mS in between each
 	for (int i = 1; i < 4; i ++) {
 		
-		LCD |= (D5_HI | D4_HI);
+		Ctx.LCD |= (D5_HI | D4_HI);
 		
-		sendToLCD(LCD); //pulse to send 000011 both through the shift register and the LCD
+		sendToLCD(Ctx.LCD); //pulse to send 000011 both through the shift register and the LCD
 		wait(3); //wait 6mS between each loop
 	}
 	
@@ -260,8 +762,8 @@ void LCDInit (void) {
 	 * Interface is 8 bits in length.
 	 */
 	//sending 00010
-	LCD &= D4_LO; //just changed D4 to LO
-	sendToLCD(LCD);
+	Ctx.LCD &= D4_LO; //just changed D4 to LO
+	sendToLCD(Ctx.LCD);
 	wait (1);
 	
 	/*
@@ -271,80 +773,80 @@ void LCDInit (void) {
 	 * can not be changed after this point.
 	 */
 	//sending the same value as previous step
-	sendToLCD(LCD);
+	sendToLCD(Ctx.LCD);
 	wait(1);
 	
 	/*sending 000NF** 
 	 * N is on DB7, 0 for one line
 	 * F is on DB6, 1 for bigger font
 	 */
-	LCD |= D7_HI;
-	LCD &= D6_LO;
-	sendToLCD(LCD);
+	Ctx.LCD |= D7_HI;
+	Ctx.LCD &= D6_LO;
+	sendToLCD(Ctx.LCD);
 	wait (1);
 	
 	/*
 	 * Display off
 	*/
 	//sending 000000
-	LCD = 0;
-	sendToLCD(LCD);
+	Ctx.LCD = 0;
+	sendToLCD(Ctx.LCD);
 	
 	//sending 001000
-	LCD |= D7_HI;
-	sendToLCD(LCD);
+	Ctx.LCD |= D7_HI;
+	sendToLCD(Ctx.LCD);
 	wait (1);
 	
 	/*
 	 * Display clear
 	*/
 	//sending 0000
-	LCD &= D7_LO;
-	sendToLCD(LCD);
+	Ctx.LCD &= D7_LO;
+	sendToLCD(Ctx.LCD);
 	
 	//sending 0001
-	LCD |= D4_HI;
-	sendToLCD(LCD);
+	Ctx.LCD |= D4_HI;
+	sendToLCD(Ctx.LCD);
 	wait (1);
 	
 	/* 
 	 * Entry mode set
 	 */
 	//sending 0000
-	LCD &= D4_LO;
-	sendToLCD(LCD);
+	Ctx.LCD &= D4_LO;
+	sendToLCD(Ctx.LCD);
 
 	/* sending 0000(I/D)S
 	 * I/D is on DB5, 1 is to increment cursor
 	 * S is on DB4, 1 is to shift screen 
 	 */
-	LCD |= D4_HI;
-	LCD |= D5_HI;
-	sendToLCD(LCD);
+	Ctx.LCD |= D4_HI;
+	Ctx.LCD |= D5_HI;
+	sendToLCD(Ctx.LCD);
 	wait (1);
 	
 	// send 0000, 1111 to turn back on
-	LCD &= D4_LO;
-	LCD &= D5_LO;
-	sendToLCD(LCD);
+	Ctx.LCD &= D4_LO;
+	Ctx.LCD &= D5_LO;
+	sendToLCD(Ctx.LCD);
 	
-	LCD |= (D4_HI | D5_HI | D6_HI | D7_HI);
-	sendToLCD(LCD);
+	Ctx.LCD |= (D4_HI | D5_HI | D6_HI | D7_HI);
+	sendToLCD(Ctx.LCD);
 	wait (1);
 	
 	/* sets cursor to start at right side
 	 */
 	
-	LCD &= D4_LO;
-	LCD &= D5_LO;
-	LCD &= D6_LO;
-	LCD &= D7_LO;
+	Ctx.LCD &= D4_LO;
+	Ctx.LCD &= D5_LO;
+	Ctx.LCD &= D6_LO;
+	Ctx.LCD &= D7_LO;
 	
-	sendToLCD(LCD);
+	sendToLCD(Ctx.LCD);
 		
-	LCD |= (D4_HI | D5_HI | D6_HI | D7_HI);
+	Ctx.LCD |= (D4_HI | D5_HI | D6_HI | D7_HI);
 	
-	sendToLCD(LCD);
+	sendToLCD(Ctx.LCD);
 	
 	wait(1);	
 }
@@ -360,22 +862,302 @@ void LCDInit (void) {
      none
 
  Description
-     clears the LCD screen
+     clears the LCD screen, and LCDputchar starts again at the first cell
  Notes
-
+		 no clear instruction is sent; the cells that were not blank are
+		 written with spaces, and those LCDputchar writes next are not even
+		 that if they are written back the same
 ****************************************************************************/
 void clearLCD(void) {
-	/*
-	 * Display clear
-	*/
-	//sending 000000
-	LCD = 0;
-	sendToLCD(LCD);
+	memset(Ctx.frame, ' ', sizeof(Ctx.frame));
+	Ctx.line = 0;
+	Ctx.column = 0;
+	Ctx.dirty = true;
+	startLCDService();
+}
 
-	//sending 0001
-	LCD |= D4_HI;
-	sendToLCD(LCD);
-	wait (1);
+/****************************************************************************
+ Function
+     LCDwriteLine
+
+ Parameters
+     uint8_t : the line, 0 for the top one
+		 const char * : the text
+
+ Returns
+     none
+
+ Description
+     makes the line show the text, padded with spaces or cut to LCD_COLUMNS,
+		 and LCDputchar carries on after it
+ Notes
+		 only the cells that differ from what the line shows are sent
+****************************************************************************/
+void LCDwriteLine(uint8_t Line, const char *pText) {
+	uint8_t column = 0;
+
+	if (Line >= LCD_LINES)
+		return;
+
+	for (; (column < LCD_COLUMNS) && (pText[column] != '\0'); column++) {
+		Ctx.frame[Line][column] = pText[column];
+	}
+	Ctx.line = Line;
+	Ctx.column = column;
+	for (; column < LCD_COLUMNS; column++) {
+		Ctx.frame[Line][column] = ' ';
+	}
+	Ctx.dirty = true;
+	startLCDService();
+}
+
+/****************************************************************************
+ Function
+     LCDputs
+
+ Parameters
+     const char * : the text
+
+ Returns
+     none
+
+ Description
+     writes the text from where LCDputchar would write next; whatever
+		 goes past the end of the line is not shown
+ Notes
+
+****************************************************************************/
+void LCDputs(const char *pText) {
+	while ((*pText != '\0') && (Ctx.column < LCD_COLUMNS)) {
+		Ctx.frame[Ctx.line][Ctx.column] = *pText;
+		Ctx.column++;
+		pText++;
+	}
+	Ctx.dirty = true;
+	startLCDService();
+}
+
+/****************************************************************************
+ Function
+     LCDputDigits
+
+ Parameters
+     const uint8_t * : the digits, each 0 to 9
+		 uint8_t : how many
+
+ Returns
+     none
+
+ Description
+     writes the digits as text from where LCDputchar would write next
+ Notes
+
+****************************************************************************/
+void LCDputDigits(const uint8_t *pDigits, uint8_t Count) {
+	char text[LCD_COLUMNS + 1];
+
+	if (Count > LCD_COLUMNS)
+		Count = LCD_COLUMNS;
+	renderDigits(text, pDigits, Count);
+	LCDputs(text);
+}
+
+/****************************************************************************
+ Function
+     LCDshowMessage
+
+ Parameters
+     LCDMessage_t : which message
+
+ Returns
+     none
+
+ Description
+     shows the message's text from the table on the first line
+ Notes
+
+****************************************************************************/
+void LCDshowMessage(LCDMessage_t Message) {
+	if (Message >= NumLCDMessages)
+		return;
+	LCDwriteLine(0, Messages[Message]);
+}
+
+/****************************************************************************
+ Function
+     LCDstartCountdown
+
+ Parameters
+     uint16_t : ticks the countdown lasts
+
+ Returns
+     none
+
+ Description
+     fills the second line with a bar, which then gets shorter one dot at a
+		 time until the ticks have gone by
+ Notes
+		 the bar only moves on COUNTDOWN_TIMER timeouts, one per dot, and each
+		 of those changes a single cell
+****************************************************************************/
+void LCDstartCountdown(uint16_t Ticks) {
+	if (Ticks == 0)
+		return;
+
+	Ctx.countdownStart = ES_Timer_GetTime();
+	Ctx.countdownTicks = Ticks;
+	Ctx.countdownOn = true;
+	updateCountdown();
+}
+
+/****************************************************************************
+ Function
+     LCDstopCountdown
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     stops the countdown and blanks the second line
+ Notes
+
+****************************************************************************/
+void LCDstopCountdown(void) {
+	if (!Ctx.countdownOn)
+		return;
+
+	Ctx.countdownOn = false;
+	ES_Timer_StopTimer(COUNTDOWN_TIMER);
+	drawBar(0);
+}
+
+/****************************************************************************
+ Function
+     updateCountdown
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     works out from the time gone by how many dots of the bar are left, draws
+		 them and starts COUNTDOWN_TIMER for when the next dot goes
+ Notes
+		 this function is a PRIVATE function
+		 the dots are worked out from the start time rather than counted, so a
+		 late timeout does not make the bar fall behind
+****************************************************************************/
+void updateCountdown (void) {
+	if (!Ctx.countdownOn)
+		return;
+
+	uint16_t elapsed = (uint16_t)(ES_Timer_GetTime() - Ctx.countdownStart);
+	if (elapsed >= Ctx.countdownTicks) {
+		drawBar(0);
+		return;
+	}
+
+	// dots left, rounded up so the last dot goes when the time is up
+	uint32_t left = Ctx.countdownTicks - elapsed;
+	uint8_t dots = (uint8_t)((left * BAR_DOTS + Ctx.countdownTicks - 1) / Ctx.countdownTicks);
+	drawBar(dots);
+
+	// the tick the bar is next one dot shorter: when left falls to the
+	// smallest time that still rounds up to dots - 1
+	uint32_t nextLeft = ((uint32_t)(dots - 1) * Ctx.countdownTicks) / BAR_DOTS;
+	ES_Timer_InitTimer(COUNTDOWN_TIMER, (uint16_t)(left - nextLeft));
+}
+
+/****************************************************************************
+ Function
+     drawBar
+
+ Parameters
+     uint8_t : dots long, up to BAR_DOTS
+
+ Returns
+     none
+
+ Description
+     full cells, then the glyph as wide as the dots left over, then spaces
+ Notes
+		 this function is a PRIVATE function
+		 does not move where LCDputchar writes next
+****************************************************************************/
+void drawBar (uint8_t Dots) {
+	for (uint8_t column = 0; column < LCD_COLUMNS; column++) {
+		uint8_t first = column * DOTS_PER_CELL;
+		char cell = ' ';
+
+		if (Dots >= first + DOTS_PER_CELL)
+			cell = FULL_BLOCK;
+		else if (Dots > first)
+			cell = (char)(Dots - first); // glyph 1 to 4
+		Ctx.frame[BAR_LINE][column] = cell;
+	}
+	Ctx.dirty = true;
+	startLCDService();
+}
+
+/****************************************************************************
+ Function
+     queueGlyphs
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     queues the four countdown glyphs into CGRAM characters 1 to 4, glyph N
+		 with its left N dots on in every row
+ Notes
+		 this function is a PRIVATE function
+		 only called with an empty queue: a CGRAM address and 32 rows fit.
+		 The LCD's address is then in CGRAM, so the next changes set a DDRAM
+		 address first
+****************************************************************************/
+void queueGlyphs (void) {
+	queueLCDByte(SET_CGRAM | (1 * GLYPH_ROWS), false);
+	for (uint8_t width = 1; width < DOTS_PER_CELL; width++) {
+		uint8_t row = (uint8_t)((0x1F << (DOTS_PER_CELL - width)) & 0x1F);
+		for (uint8_t i = 0; i < GLYPH_ROWS; i++) {
+			queueLCDByte(row, true);
+		}
+	}
+	Ctx.address = ADDRESS_UNKNOWN;
+	Ctx.glyphsLoaded = true;
+}
+
+/****************************************************************************
+ Function
+     renderDigits
+
+ Parameters
+     char * : where the text goes, Count + 1 chars
+		 const uint8_t * : the digits
+		 uint8_t : how many
+
+ Returns
+     none
+
+ Description
+     turns each digit into its character, '?' for anything over 9, and
+		 ends the text
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void renderDigits (char *pDest, const uint8_t *pDigits, uint8_t Count) {
+	for (uint8_t i = 0; i < Count; i++) {
+		pDest[i] = (pDigits[i] <= 9) ? (char)('0' + pDigits[i]) : '?';
+	}
+	pDest[Count] = '\0';
 }
 
 /****************************************************************************
@@ -391,65 +1173,17 @@ void clearLCD(void) {
  Description
      writes a single letter that was at the input onto the LCD screne
  Notes
-		 Just a reminder, LCD = D4-D5-D6-D7-RS-RW-E-empty
-		 The ordering of the char being written was reversed, so we use an array
-		 to flip the inputs accordingly
+		 the letter goes into the copy of the display; letters past the end
+		 of the line are not shown, as on the LCD
 ****************************************************************************/
 void LCDputchar (char letter) {
+	if (Ctx.column >= LCD_COLUMNS)
+		return;
 
-	//writes each bit of the letter into a separate array entry
-	uint8_t char_bits[8] = {0, 0, 0, 0, 0, 0 ,0 ,0};
-	for (uint8_t i = 0; i < 8; i++) {
-		if ((letter & 0x01) == 0x01)
-			char_bits[i] = 1;
-		letter = letter >> 1;
-	}
-	
-	// Clears the data pin bits of LCD but keeps RS, RW, etc.
-	LCD &= D4_LO;
-	LCD &= D5_LO;
-	LCD &= D6_LO;
-	LCD &= D7_LO;
-	LCD |= RS_HI; //data mode
-	
-	// Sets upper 4 bits (in reverse order) to be sent
-	if (char_bits[4])
-		LCD |= (0x80); // Set 1000000
-	if (char_bits[5])
-		LCD |= (0x40); // Set 0100000
-	if (char_bits[6])
-		LCD |= (0x20); // Set 0010000
-	if (char_bits[7])
-		LCD |= (0x10); // Set 0001000
-
-	sendToLCD (LCD); //sends upper 4 bits
-	
-	//kills time
-	for (int i = 1; i < 50; i ++){
-		HWREG(SYSCTL_RCGCGPIO);
-	}
-	
-	// Clears the data pin bits of LCD but keeps RS, RW.
-	LCD &= D4_LO;
-	LCD &= D5_LO;
-	LCD &= D6_LO;
-	LCD &= D7_LO;
-	// Sets lower 4 bits (in reverse order) to be sent
-	if (char_bits[0])
-		LCD |= (0x80); // Set 1000000
-	if (char_bits[1])
-		LCD |= (0x40); // Set 0100000
-	if (char_bits[2])
-		LCD |= (0x20); // Set 0010000
-	if (char_bits[3])
-		LCD |= (0x10); // Set 0001000
-	
-	sendToLCD (LCD); //sends upper 4 bits
-	
-	//kills time
-	for (int i = 1; i < 50; i ++){
-		HWREG(SYSCTL_RCGCGPIO);
-	}
+	Ctx.frame[Ctx.line][Ctx.column] = letter;
+	Ctx.column++;
+	Ctx.dirty = true;
+	startLCDService();
 }
 
 /****************************************************************************
@@ -465,13 +1199,26 @@ void LCDputchar (char letter) {
  Description
      sets a variable "messageNumber" such that the set of messages welcoming DrEd
 		 back and showing him passcodes is starting at the beginning again
-		 (specifically, with "Welcome DrEd")
+		 (specifically, with "Welcome DrEd"), and writes out the text of all
+		 the messages for printLCDmessage
  Notes
 		 use this function so that the next time the three tape sensors are covered again
 		 the message begins with "Welcome DrEd" instead of with a passcode or another mesasge
+
+		 the passcodes are read here, once, so call it after randomizePasswords
 ****************************************************************************/
 void resetLCDmessage(void) {
-	messageNumber = 1;
+	strncpy(Ctx.pages[0], Messages[WelcomeMessage], LCD_COLUMNS);
+	strncpy(Ctx.pages[1], Messages[PasscodesMessage], LCD_COLUMNS);
+	Ctx.pages[0][LCD_COLUMNS] = '\0';
+	Ctx.pages[1][LCD_COLUMNS] = '\0';
+	// pages 2 to 5 are passcodes 1 to 4
+	for (uint8_t page = 2; page < LCD_PAGES; page++) {
+		uint8_t digits[MAX_PASS_LENGTH];
+		unpackPassword(getPassword(page - 1), digits);
+		renderDigits(Ctx.pages[page], digits, MAX_PASS_LENGTH);
+	}
+	Ctx.messageNumber = 1;
 }
 
 /****************************************************************************
@@ -495,152 +1242,16 @@ void resetLCDmessage(void) {
 
 		 The messages being printed will loop through the above 6 messages
  Notes
+		 the text comes from the pages resetLCDmessage wrote, and only the
+		 cells that differ from the page before are sent
 ****************************************************************************/
 void printLCDmessage(void) {
-	// c gets used to translate the randomly generated passcodes into numbers to be shown on the LCD
-	char c[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
-	
-	switch (messageNumber) {
-		case 1:
-			clearLCD();
-			LCDputchar('W');
-			LCDputchar('e');
-			LCDputchar('l');
-			LCDputchar('c');
-			LCDputchar('o');
-			LCDputchar('m');
-			LCDputchar('e');
-			LCDputchar(' ');
-			LCDputchar('D');
-			LCDputchar('r');
-			LCDputchar('E');
-			LCDputchar('d');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			
-			messageNumber = 2;
-			break;
-		
-		case 2:
-			clearLCD();
-			LCDputchar('P');
-			LCDputchar('a');
-			LCDputchar('s');
-			LCDputchar('s');
-			LCDputchar('c');
-			LCDputchar('o');
-			LCDputchar('d');
-			LCDputchar('e');
-			LCDputchar('s');
-			LCDputchar(':');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			messageNumber = 3;
-			break;
-		
-		case 3:
-			clearLCD();
-			LCDputchar( c[getPassword(1)[0]]);
-			LCDputchar( c[getPassword(1)[1]]);
-			LCDputchar( c[getPassword(1)[2]]);
-			LCDputchar( c[getPassword(1)[3]]);
-			LCDputchar( c[getPassword(1)[4]]);
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			messageNumber = 4;
-			break;
-			
-		case 4:
-			clearLCD();
-			LCDputchar( c[getPassword(2)[0]]);
-			LCDputchar( c[getPassword(2)[1]]);
-			LCDputchar( c[getPassword(2)[2]]);
-			LCDputchar( c[getPassword(2)[3]]);
-			LCDputchar( c[getPassword(2)[4]]);
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			messageNumber = 5;
-			break;
-		
-		case 5:
-			clearLCD();
-			LCDputchar( c[getPassword(3)[0]]);
-			LCDputchar( c[getPassword(3)[1]]);
-			LCDputchar( c[getPassword(3)[2]]);
-			LCDputchar( c[getPassword(3)[3]]);
-			LCDputchar( c[getPassword(3)[4]]);
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			messageNumber = 6;
-			break;
-			
-		case 6:
-			clearLCD();
-			LCDputchar( c[getPassword(4)[0]]);
-			LCDputchar( c[getPassword(4)[1]]);
-			LCDputchar( c[getPassword(4)[2]]);
-			LCDputchar( c[getPassword(4)[3]]);
-			LCDputchar( c[getPassword(4)[4]]);
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			messageNumber = 1;
-			break;
-	}
+	// nothing to show until resetLCDmessage has written the pages
+	if ((Ctx.messageNumber == 0) || (Ctx.messageNumber > LCD_PAGES))
+		return;
+
+	LCDwriteLine(0, Ctx.pages[Ctx.messageNumber - 1]);
+	Ctx.messageNumber = (Ctx.messageNumber % LCD_PAGES) + 1;
 }
 
 /****************************************************************************
@@ -660,25 +1271,7 @@ void printLCDmessage(void) {
  Notes
 ****************************************************************************/
 void printAuthorizedMessage(void) {
-			clearLCD();
-			LCDputchar('A');
-			LCDputchar('u');
-			LCDputchar('t');
-			LCDputchar('h');
-			LCDputchar('o');
-			LCDputchar('r');
-			LCDputchar('i');
-			LCDputchar('z');
-			LCDputchar('e');
-			LCDputchar('d');
-			LCDputchar('!');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
+	LCDshowMessage(AuthorizedMessage);
 }
 
 /****************************************************************************
@@ -698,26 +1291,7 @@ void printAuthorizedMessage(void) {
  Notes
 ****************************************************************************/
 void printTimeUp(void) {
-			clearLCD();
-			LCDputchar('Y');
-			LCDputchar('o');
-			LCDputchar('u');
-			LCDputchar('r');
-			LCDputchar(' ');
-			LCDputchar('T');
-			LCDputchar('i');
-			LCDputchar('m');
-			LCDputchar('e');
-			LCDputchar(' ');
-			LCDputchar('I');
-			LCDputchar('s');
-			LCDputchar(' ');
-			LCDputchar('U');
-			LCDputchar('p');
-			LCDputchar('!');
-			LCDputchar(' ');
-			LCDputchar(' ');
-	
+	LCDshowMessage(TimeUpMessage);
 }
 
 /****************************************************************************
@@ -737,26 +1311,7 @@ void printTimeUp(void) {
  Notes
 ****************************************************************************/
 void printIncorrectMessage(void) {
-			clearLCD();
-			LCDputchar('I');
-			LCDputchar('n');
-			LCDputchar('c');
-			LCDputchar('o');
-			LCDputchar('r');
-			LCDputchar('r');
-			LCDputchar('e');
-			LCDputchar('c');
-			LCDputchar('t');
-			LCDputchar(' ');
-			LCDputchar('P');
-			LCDputchar('a');
-			LCDputchar('s');
-			LCDputchar('s');
-			LCDputchar('w');
-			LCDputchar('o');
-			LCDputchar('r');
-			LCDputchar('d');
-	
+	LCDshowMessage(IncorrectMessage);
 }
 
 /****************************************************************************
@@ -776,23 +1331,7 @@ void printIncorrectMessage(void) {
  Notes
 ****************************************************************************/
 void printArmedMessage(void) {
-			clearLCD();
-			LCDputchar('A');
-			LCDputchar('r');
-			LCDputchar('m');
-			LCDputchar('e');
-			LCDputchar('d');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
-			LCDputchar(' ');
+	LCDshowMessage(ArmedMessage);
 }
 
 /****************************************************************************
@@ -821,6 +1360,15 @@ int main(void)
 	LCDputchar(' ');
 	LCDputchar('D');
 	LCDputchar('r');
+
+	// no framework runs here, so play the LCD service's part by hand
+	while (isLCDBusy()) {
+		ES_Event ThisEvent;
+		wait(LCD_TICKS);
+		ThisEvent.EventType = ES_TIMEOUT;
+		ThisEvent.EventParam = LCD_TIMER;
+		RunLCDService(ThisEvent);
+	}
 	return 0;
 }
 #endif
@@ -8,17 +8,99 @@
 #ifndef LCD_H
 #define LCD_H
 #include <stdint.h>
+#include <stdbool.h>
+#include "ES_Configure.h"
+#include "ES_Framework.h"
 #include "helperFunctions.h"
+#include "passwordGenerator.h"
+
+/* NOTES:
+
+	Only LCDInit talks to the LCD directly, and it waits as it goes. Every
+	other function here writes into a copy of the display kept in memory
+	and returns at once. When the queue is empty the LCD service compares
+	that copy with what the LCD already shows, queues a DDRAM address and
+	the letters for the cells that changed, and sends one nibble of the
+	queue per tick of LCD_TIMER. Writing the same text twice costs nothing,
+	and clearLCD only costs the cells that were not blank.
+
+	Define LCD_SSI for the whole project to drive the shift register from
+	SSI0 and uDMA (PA2 SCK, PA3 RCK, PA5 data) instead of bit-banging PC4
+	to PC6; see the pin notes in LCD.c. The LED shift register's data and
+	SCK move from PA2 and PA3 to PA6 and PA7 in that build, so the board
+	has to be wired for it. The queue then goes out in one transfer per tick, and the
+	CPU only copies it into frames.
+
+	Make sure to edit 'ES_Configure.h':
+		add the LCD service (any free priority):
+			#define SERV_3_HEADER "LCD.h"
+			#define SERV_3_INIT InitLCDService
+			#define SERV_3_RUN RunLCDService
+			#define SERV_3_QUEUE_SIZE 3
+		and give it two timers:
+			#define TIMER9_RESP_FUNC PostLCDService
+			#define TIMER10_RESP_FUNC PostLCDService
+			#define LCD_TIMER 9
+			#define COUNTDOWN_TIMER 10
+*/
+
+// the display as fitted, two lines of 16
+#define LCD_LINES 2
+#define LCD_COLUMNS 16
+
+// messages printLCDmessage goes through: welcome, "Passcodes:" and the passcodes
+#define LCD_PAGES (2 + NUM_PASSWORDS)
+
+// the messages in LCD.c's table, for LCDshowMessage; a new message only
+// needs a name here and its text in the table
+typedef enum { WelcomeMessage, PasscodesMessage, AuthorizedMessage,
+               TimeUpMessage, IncorrectMessage, ArmedMessage,
+               NumLCDMessages } LCDMessage_t ;
+
+// nibbles the queue holds: changing every cell takes the letters and a DDRAM
+// address for each line, two nibbles apiece
+#define LCD_QUEUE_SIZE (2 * LCD_LINES * (LCD_COLUMNS + 1))
 
 // Public Function Prototypes
 
+// Initializes the LCD service
+bool InitLCDService (uint8_t Priority);
+
+// Post event to the LCD service
+bool PostLCDService (ES_Event ThisEvent);
+
+// sends the queue to the LCD, one nibble per LCD_TIMER timeout
+ES_Event RunLCDService (ES_Event ThisEvent);
+
+// true while some of what was written has not reached the LCD yet
+bool isLCDBusy (void);
+
  //initializes Tiva ports and then 4 bit mode of LCD
 void LCDInit (void);
 
  //clears the LCD screen
 void clearLCD(void);
 
-// resets the LCD screen so that it beings at "Welcome DrEd" if LCD is activated
+// shows the text on a line (0 or 1), padded with spaces or cut to LCD_COLUMNS
+void LCDwriteLine(uint8_t Line, const char *pText);
+
+// writes the text where LCDputchar would, as far as the end of the line
+void LCDputs(const char *pText);
+
+// writes digits (0 to 9 each, as in a passcode) as text where LCDputchar would
+void LCDputDigits(const uint8_t *pDigits, uint8_t Count);
+
+// shows one of the messages on the first line
+void LCDshowMessage(LCDMessage_t Message);
+
+// fills the second line with a bar that runs down over the given ticks
+void LCDstartCountdown(uint16_t Ticks);
+
+// stops the countdown and blanks the second line
+void LCDstopCountdown(void);
+
+// resets the LCD screen so that it beings at "Welcome DrEd" if LCD is activated,
+// and reads the passcodes for the messages
 void resetLCDmessage(void);
 
 // prints out sequence of LCD messages that welcome DrEd back and gives him passcodes
@@ -0,0 +1,289 @@
+/****************************************************************************
+ Module
+   LEDAnimation.c
+
+ Revision
+   1.0.1
+
+ Description
+   This is a LED animation file for implementing a simple service under the 
+   Gen2 Events and Services Framework. It plays keyframe sequences on the
+	 tower LEDs, with the brightness shown by the refresh interrupt in LEDs.c.
+
+ NOTES: **********************************************************************
+	A keyframe moves the LEDs in its mask from wherever they are to its
+	level, in a straight line over its steps; 0 steps jumps straight there,
+	and a mask of 0 just waits. The keyframes of a sequence play one after
+	the other.
+ *****************************************************************************
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+/* include header files for this service
+*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "LEDAnimation.h"
+#include "LEDs.h"
+#include "DisarmFSM.h"
+#include "GameContext.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define NUM_TOWER_LEDS 8 // LEDs in bank 0, the tower's
+#define FADE_STEPS 5 // 100 mS
+
+/*---------------------------- Module Functions ---------------------------*/
+/* prototypes for private functions for this service.They should be functions
+   relevant to the behavior of this service
+*/
+void playAnimation(LEDAnimation_t Animation);
+void beginKeyframe(void);
+void showLevels(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the priority and the animation being played are kept in AnimationContext_t
+// (see GameContext.h)
+#define Ctx (pGame->Animation)
+
+typedef struct {
+	uint8_t Mask; // the LEDs this keyframe moves
+	uint8_t Level; // where they end up
+	uint8_t Steps; // how many steps it takes them
+} Keyframe_t;
+
+typedef struct {
+	const Keyframe_t *pKeyframes;
+	uint8_t NumKeyframes;
+	bool Loop;
+	bool Hold; // its LEDs stay at their last levels when it ends
+} Animation_t;
+
+// tiers 4 to 6 fade up one after the other, 300 mS apart
+static const Keyframe_t Victory[] = {
+	{LED_TIER4, LED_MAX_LEVEL, FADE_STEPS}, {0, 0, 10},
+	{LED_TIER5, LED_MAX_LEVEL, FADE_STEPS}, {0, 0, 10},
+	{LED_TIER6, LED_MAX_LEVEL, FADE_STEPS}, {0, 0, 10},
+};
+
+#define ANIMATION(a, loop, hold) { a, sizeof(a) / sizeof(a[0]), loop, hold }
+
+static const Animation_t Animations[NumLEDAnimations] = {
+	{ NULL, 0, false, false }, // NoAnimation
+	ANIMATION(Victory, false, true), // VictoryAnimation
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     InitLEDAnimationService
+
+ Parameters
+     uint8_t : the priority of this service
+
+ Returns
+     bool, false if error in initialization, true otherwise
+
+ Description
+     Saves away the priority, and posts the initial transition event
+ Notes
+		 the LEDs and their refresh timer are set up by LEDShiftRegInit
+****************************************************************************/
+bool InitLEDAnimationService ( uint8_t Priority ) {
+	ES_Event ThisEvent;
+
+	Ctx.MyPriority = Priority;
+
+	// post the initial transition event
+	ThisEvent.EventType = ES_INIT;
+	return ES_PostToService(Ctx.MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     PostLEDAnimationService
+
+ Parameters
+     ES_Event ThisEvent ,the event to post to the queue
+
+ Returns
+     bool false if the Enqueue operation failed, true otherwise
+
+ Description
+     Posts an event to this service's queue
+ Notes
+
+****************************************************************************/
+bool PostLEDAnimationService( ES_Event ThisEvent ) {
+	return ES_PostToService(Ctx.MyPriority, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+     RunLEDAnimationService
+
+ Parameters
+     ES_Event : the event to process
+
+ Returns
+     ES_Event, ES_NO_EVENT
+
+ Description
+     PLAY_ANIMATION starts the animation in the event parameter over the one
+		 playing. Every ANIMATION_TIMER timeout moves it on a step, and on to
+		 the next keyframe once the steps of this one are done
+ Notes
+
+****************************************************************************/
+ES_Event RunLEDAnimationService( ES_Event ThisEvent ) {
+	ES_Event ReturnEvent;
+	ReturnEvent.EventType = ES_NO_EVENT;
+
+	if (ThisEvent.EventType == PLAY_ANIMATION) {
+		playAnimation((LEDAnimation_t)ThisEvent.EventParam);
+		return ReturnEvent;
+	}
+
+	if ((ThisEvent.EventType != ES_TIMEOUT) || (ThisEvent.EventParam != ANIMATION_TIMER)
+			|| (Ctx.Current == NoAnimation))
+		return ReturnEvent;
+
+	const Keyframe_t *pKeyframe = &Animations[Ctx.Current].pKeyframes[Ctx.Keyframe];
+	Ctx.Step++;
+	for (uint8_t led = 0; led < NUM_TOWER_LEDS; led++) {
+		if (pKeyframe->Mask & (1 << led)) {
+			int16_t change = (int16_t)pKeyframe->Level - Ctx.From[led];
+			Ctx.Levels[led] = (uint8_t)(Ctx.From[led] + change * Ctx.Step / pKeyframe->Steps);
+		}
+	}
+	if (Ctx.Step >= pKeyframe->Steps) {
+		Ctx.Keyframe++;
+		beginKeyframe();
+	}
+	showLevels();
+	if (Ctx.Playing)
+		ES_Timer_InitTimer(ANIMATION_TIMER, ANIMATION_STEP_TICKS);
+	return ReturnEvent;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+/****************************************************************************
+ Function
+     playAnimation
+
+ Parameters
+     LEDAnimation_t : the animation to start, NoAnimation to stop
+
+ Returns
+     none
+
+ Description
+     starts the animation with all its LEDs dark, or gives the LEDs back
+		 to on/off for NoAnimation
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void playAnimation(LEDAnimation_t Animation) {
+	ES_Timer_StopTimer(ANIMATION_TIMER);
+	Ctx.Playing = false;
+	Ctx.Animated = 0;
+	for (uint8_t led = 0; led < NUM_TOWER_LEDS; led++) {
+		Ctx.Levels[led] = 0;
+	}
+
+	if ((Animation == NoAnimation) || (Animation >= NumLEDAnimations)) {
+		Ctx.Current = NoAnimation;
+		setLEDLevels(0, 0, NULL);
+		return;
+	}
+
+	// every LED it moves is its own from the start
+	const Animation_t *pAnimation = &Animations[Animation];
+	for (uint8_t i = 0; i < pAnimation->NumKeyframes; i++) {
+		Ctx.Animated |= pAnimation->pKeyframes[i].Mask;
+	}
+	Ctx.Current = Animation;
+	Ctx.Keyframe = 0;
+	Ctx.Playing = true;
+	beginKeyframe();
+	showLevels();
+	if (Ctx.Playing)
+		ES_Timer_InitTimer(ANIMATION_TIMER, ANIMATION_STEP_TICKS);
+}
+
+/****************************************************************************
+ Function
+     beginKeyframe
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     sets up Ctx.Keyframe, jumping through the ones with no steps; at the
+		 end of the animation starts it over or stops, giving its LEDs back
+		 to on/off unless it holds, and posts ANIMATION_DONE to DisarmFSM
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void beginKeyframe(void) {
+	const Animation_t *pAnimation = &Animations[Ctx.Current];
+
+	// each keyframe at most once, so a loop of jumps cannot run forever
+	for (uint8_t i = 0; i <= pAnimation->NumKeyframes; i++) {
+		if (Ctx.Keyframe >= pAnimation->NumKeyframes) {
+			if (!pAnimation->Loop) {
+				Ctx.Playing = false;
+				if (!pAnimation->Hold)
+					Ctx.Animated = 0; // the next showLevels lets them go
+				ES_Event ThisEvent;
+				ThisEvent.EventType = ANIMATION_DONE;
+				ThisEvent.EventParam = Ctx.Current;
+				PostDisarmFSM(ThisEvent);
+				return;
+			}
+			Ctx.Keyframe = 0;
+		}
+
+		const Keyframe_t *pKeyframe = &pAnimation->pKeyframes[Ctx.Keyframe];
+		if (pKeyframe->Steps > 0) {
+			for (uint8_t led = 0; led < NUM_TOWER_LEDS; led++) {
+				Ctx.From[led] = Ctx.Levels[led];
+			}
+			Ctx.Step = 0;
+			return;
+		}
+		for (uint8_t led = 0; led < NUM_TOWER_LEDS; led++) {
+			if (pKeyframe->Mask & (1 << led))
+				Ctx.Levels[led] = pKeyframe->Level;
+		}
+		Ctx.Keyframe++;
+	}
+	Ctx.Playing = false;
+}
+
+/****************************************************************************
+ Function
+     showLevels
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     hands the levels of the animated LEDs to the refresh interrupt
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void showLevels(void) {
+	setLEDLevels(0, Ctx.Animated, Ctx.Levels);
+}
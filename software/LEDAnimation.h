@@ -0,0 +1,65 @@
+/****************************************************************************
+ 
+  Header file for LEDAnimation service 
+  based on the Gen 2 Events and Services Framework
+
+ ****************************************************************************/
+
+#ifndef LEDAnimation_H
+#define LEDAnimation_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ES_Types.h"
+
+/* NOTES:
+
+	The service plays keyframe sequences on the tower LEDs (bank 0 of
+	LEDs.h): fades, chases and blinks. Every ANIMATION_STEP_TICKS it works
+	out the brightness of the LEDs the sequence moves and hands them to
+	setLEDLevels, whose timer interrupt shows them. The LEDs a sequence
+	does not move keep their on/off state. When a sequence that does not
+	loop ends, its LEDs go back to their on/off state too, and the refresh
+	interrupt stops if nothing else is animated; one that holds
+	(VictoryAnimation) leaves them at their last levels until the next one
+	is played. Either way the service posts ANIMATION_DONE to DisarmFSM,
+	with the animation in the parameter, so the game goes on when the LEDs
+	are done however long the sequence is. DisarmFSM sets the held LEDs
+	on and plays NoAnimation to let them go.
+
+	Make sure to edit 'ES_Configure.h':
+		add the service (any free priority):
+			#define SERV_4_HEADER "LEDAnimation.h"
+			#define SERV_4_INIT InitLEDAnimationService
+			#define SERV_4_RUN RunLEDAnimationService
+			#define SERV_4_QUEUE_SIZE 3
+		add PLAY_ANIMATION and ANIMATION_DONE to ES_EventTyp_t, and give it
+		a timer:
+			#define TIMER11_RESP_FUNC PostLEDAnimationService
+			#define ANIMATION_TIMER 11
+
+	To play an animation, do the following:
+					ES_Event ThisEvent;
+					ThisEvent.EventType = PLAY_ANIMATION;
+					ThisEvent.EventParam = VictoryAnimation;
+					PostLEDAnimationService(ThisEvent);
+	NoAnimation stops the one playing and gives its LEDs back to on/off.
+*/
+
+typedef enum { NoAnimation, VictoryAnimation, NumLEDAnimations } LEDAnimation_t ;
+
+// ticks between two steps of an animation (20 mS)
+#define ANIMATION_STEP_TICKS 10
+
+// Public Function Prototypes
+
+// Initializes the service
+bool InitLEDAnimationService ( uint8_t Priority );
+
+// Post event to the service
+bool PostLEDAnimationService( ES_Event ThisEvent );
+
+// Plays animations
+ES_Event RunLEDAnimationService( ES_Event ThisEvent );
+
+#endif /* LEDAnimation_H */
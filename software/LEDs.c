@@ -6,44 +6,81 @@
 
  Description
    This file contains the function that will control the LED array using the shift 
-	 register data inputs, as well as the RCK/SCK clocks. It will take an ARRAY of 
-	 8 numbers, 0 or 1 that will correspond to the 7 LEDs and one blank spot
+	 register data inputs, as well as the RCK/SCK clocks. The LEDs are kept as
+	 one byte, a bit for each of the 7 LEDs and one blank spot, and only sent
+	 when it changes
 ****************************************************************************/
 #include "LEDs.h"
 
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_gpio.h"
 #include "inc/hw_sysctl.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_ints.h"
 #include "driverlib/sysctl.h"
 #include "ES_Port.h"
 #include "ES_Timers.h"
 #include "EnablePA25_PB23_PD7_PF0.h"
 #include "termio.h"
 #include "helperFunctions.h"
+#include "GameContext.h"
+#include "ShiftBus.h"
 
 #include "driverlib/gpio.h"
 #include "driverlib/interrupt.h"
 #include "utils/uartstdio.h"
 /****************************************************************************
-  Change these values if ports A2 (data), A3 (RCK), A4 (SCK) are
+  Change these values if ports A2 (data), A3 (SCK), A4 (RCK) are
 	not being used for the shift register
 ****************************************************************************/
 #define SHIFT_PORT_DEC SYSCTL_RCGCGPIO_R0 //port A
 #define SHIFT_PORT GPIO_PORTA_BASE // port A base
+#ifdef LCD_SSI
+// SSI0 has PA2, PA3 and PA5 for the LCD (see LCD.c), so data and SCK
+// move to PA6 and PA7, which nothing else uses
+#define SHIFT_DATA GPIO_PIN_6 // pin 6
+#define SHIFT_SCK GPIO_PIN_7 // pin 7
+#else
 #define SHIFT_DATA GPIO_PIN_2 // pin 2
 #define SHIFT_SCK GPIO_PIN_3 // pin 3
+#endif
 #define SHIFT_RCK GPIO_PIN_4 // pin 4
 
-#define ALL_BITS (0xff <<2)
+/* the brightness refresh: Timer 2A, 32 bit periodic, its interval taken
+	 up at the next timeout so the interrupt can load the slot after the one
+	 just starting
+*/
+#define REFRESH_TIMER TIMER2_BASE
+#define REFRESH_TIMER_DEC SYSCTL_RCGCTIMER_R2
+#define REFRESH_INT_BIT BIT(INT_TIMER2A - 16) // its bit in NVIC_EN0
+// the shortest plane, long enough for a chain transfer of 16 banks
+#define BAM_SLOT_US 64
+#define BAM_SLOT_CLOCKS (BAM_SLOT_US * CLOCKS_PER_US)
+
+#define BIT(x) (1 << (x))
+
+// this module's part of the running station's context
+#define Ctx (pGame->LEDs)
+
+// the shift registers, LED_REGISTERS 595s with LED 0 of a bank on its
+// last output
+static const ShiftBus_t LEDBus = {
+	SHIFT_PORT, SHIFT_PORT_DEC, SHIFT_DATA, SHIFT_SCK, SHIFT_RCK,
+	LED_REGISTERS, false
+};
 
 // Prviate Function Prototypes
-void SCKPulse (void);
-void RCKPulse (void);
+bool sendLEDs (void);
+void initRefreshTimer (void);
+void startRefresh (void);
+void stopRefresh (void);
 
 /****************************************************************************
  Function
@@ -66,115 +103,397 @@ void LEDShiftRegInit (void) {
 	// initializes timer -- matching the overall module which uses the 2mS rate
 	_HW_Timer_Init(ES_Timer_RATE_2mS);
 	
-	// pin initialization to follow
-	HWREG(SYSCTL_RCGCGPIO) |= (SHIFT_PORT_DEC); // enable port A
-	HWREG(SHIFT_PORT + GPIO_O_DEN) |= (SHIFT_DATA | SHIFT_SCK | SHIFT_RCK); //enables pins
-	HWREG(SHIFT_PORT + GPIO_O_DIR) |= (SHIFT_DATA | SHIFT_SCK | SHIFT_RCK); // makes pins as ouputs
-	
-	//writes pins LO to make sure it starts out LO (good for pulsing)
-	HWREG(SHIFT_PORT+(GPIO_O_DATA + ALL_BITS)) &= ~(SHIFT_DATA | SHIFT_SCK | SHIFT_RCK); 
+	// pin initialization to follow, pins start out LO (good for pulsing)
+	ShiftBusInit(&LEDBus);
+	initRefreshTimer();
+
+	// whatever the chain holds, the next flushLEDs sends the LEDs
+	Ctx.known = false;
+	for (uint8_t bank = 0; bank < LED_REGISTERS; bank++) {
+		Ctx.dirty[bank] = true;
+	}
+	Ctx.refreshing = false;
 	
 	puts("\n\r Timer, Shift Register port and pins intialization complete \r\n");
 }
 
 /****************************************************************************
  Function
-     SCKPulse
+     turnOnLEDs
 
  Parameters
+     uint8_t : the LEDs to turn on
+
+ Returns
      none
 
+ Description
+     sets their bits in the copy of the shift register
+ Notes
+		 nothing is sent until flushLEDs
+****************************************************************************/
+void turnOnLEDs (uint8_t Mask) {
+	setLEDs(Ctx.lit[0] | Mask);
+}
+
+/****************************************************************************
+ Function
+     turnOffLEDs
+
+ Parameters
+     uint8_t : the LEDs to turn off
+
  Returns
      none
 
  Description
-     pulses the pin connected the SCK by writing it HI, then back to LO again
+     clears their bits in the copy of the shift register
  Notes
+		 nothing is sent until flushLEDs
+****************************************************************************/
+void turnOffLEDs (uint8_t Mask) {
+	setLEDs(Ctx.lit[0] & ~Mask);
+}
+
+/****************************************************************************
+ Function
+     toggleLEDs
+
+ Parameters
+     uint8_t : the LEDs to turn the other way
 
+ Returns
+     none
+
+ Description
+     flips their bits in the copy of the shift register
+ Notes
+		 nothing is sent until flushLEDs
 ****************************************************************************/
-void SCKPulse (void) {
-	// sets SCK pin HI
-	HWREG(SHIFT_PORT+(GPIO_O_DATA + ALL_BITS)) |= SHIFT_SCK; 
-	for (int i = 1; i < 50; i ++){
-		HWREG(SYSCTL_RCGCGPIO);
-	}
-	// sets SCK pin back LO
-	HWREG(SHIFT_PORT+(GPIO_O_DATA + ALL_BITS)) &= ~SHIFT_SCK; 
+void toggleLEDs (uint8_t Mask) {
+	setLEDs(Ctx.lit[0] ^ Mask);
+}
+
+/****************************************************************************
+ Function
+     setLEDs
+
+ Parameters
+     uint8_t : the LEDs that should be on
+
+ Returns
+     none
+
+ Description
+     replaces the copy of the first shift register
+ Notes
+		 nothing is sent until flushLEDs
+****************************************************************************/
+void setLEDs (uint8_t Lit) {
+	setLEDBank(0, Lit);
 }
 
 /****************************************************************************
  Function
-     RCKPulse
+     getLEDs
 
  Parameters
      none
 
+ Returns
+     uint8_t : the LEDs that are on, or will be at the next flushLEDs
+
+ Description
+     reads the copy of the shift register
+ Notes
+
+****************************************************************************/
+uint8_t getLEDs (void) {
+	return Ctx.lit[0];
+}
+
+/****************************************************************************
+ Function
+     setLEDBank
+
+ Parameters
+     uint8_t : the bank, 0 to LED_REGISTERS - 1
+		 uint8_t : its LEDs that should be on
+
  Returns
      none
 
  Description
-     pulses the pin connected the RCK by writing it HI, then back to LO again
+     replaces the copy of one shift register in the chain, and marks it
+		 dirty if that changes it
+ Notes
+		 nothing is sent until flushLEDs; a bank past the chain is ignored
+****************************************************************************/
+void setLEDBank (uint8_t Bank, uint8_t Lit) {
+	if (Bank >= LED_REGISTERS)
+		return;
+	if (Lit != Ctx.lit[Bank])
+		Ctx.dirty[Bank] = true;
+	Ctx.lit[Bank] = Lit;
+}
+
+/****************************************************************************
+ Function
+     getLEDBank
+
+ Parameters
+     uint8_t : the bank, 0 to LED_REGISTERS - 1
+
+ Returns
+     uint8_t : its LEDs that are on, or will be at the next flushLEDs; 0
+		 for a bank past the chain
+
+ Description
+     reads the copy of one shift register in the chain
  Notes
 
 ****************************************************************************/
-void RCKPulse (void) {
-	// sets RCK pin HI
-	HWREG(SHIFT_PORT+(GPIO_O_DATA + ALL_BITS)) |= SHIFT_RCK; 
-	for (int i = 1; i < 50; i ++){
-		HWREG(SYSCTL_RCGCGPIO);
+uint8_t getLEDBank (uint8_t Bank) {
+	if (Bank >= LED_REGISTERS)
+		return 0;
+	return Ctx.lit[Bank];
+}
+
+/****************************************************************************
+ Function
+     flushLEDs
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     sends the LEDs to the chain, if a bank has changed since the last time
+		 and the chain does not already hold it
+ Notes
+		 a LED turned on and back off again before the flush sends nothing.
+		 Only the dirty banks are compared, but a change in any of them
+		 shifts the whole chain (see LEDs.h). While the refresh interrupt
+		 runs it sends the LEDs with the next plane instead. If the shift
+		 bus drops the transfer, the banks stay dirty and sent stays as it
+		 was, so the next flush tries again
+****************************************************************************/
+void flushLEDs (void) {
+	bool changed = !Ctx.known;
+
+	for (uint8_t bank = 0; bank < LED_REGISTERS; bank++) {
+		if (Ctx.dirty[bank] && (Ctx.lit[bank] != Ctx.sent[bank]))
+			changed = true;
+	}
+	if (changed) {
+		if (!Ctx.refreshing && !sendLEDs())
+			return;
+		memcpy(Ctx.sent, Ctx.lit, sizeof(Ctx.sent));
+		Ctx.known = true;
+	}
+	for (uint8_t bank = 0; bank < LED_REGISTERS; bank++) {
+		Ctx.dirty[bank] = false;
 	}
-	// sets RCK pin back LO
-	HWREG(SHIFT_PORT+(GPIO_O_DATA + ALL_BITS)) &= ~SHIFT_RCK; 
-	
 }
 
 /****************************************************************************
  Function
-     setLED
+     sendLEDs
 
  Parameters
-     char array[8]
+     none
+
+ Returns
+     bool, false if the shift bus dropped the transfer
+
+ Description
+     Writes every bank into the chain, the one furthest from the Tiva first
+		 and LED 0 of each first, and latches them, so that this function
+		 alone will turn the corresponding LEDs on/off
+ Notes
+		 this function is a PRIVATE function
+		 A LO output turns its LED on, so the bits go out inverted
+****************************************************************************/
+bool sendLEDs (void) {
+	uint8_t frame[LED_REGISTERS];
+
+	for (uint8_t i = 0; i < LED_REGISTERS; i++) {
+		frame[i] = (uint8_t)~Ctx.lit[LED_REGISTERS - 1 - i];
+	}
+	return ShiftBusSend(&LEDBus, frame, 1);
+}
+
+/****************************************************************************
+ Function
+     setLEDLevels
+
+ Parameters
+     uint8_t : the bank, 0 to LED_REGISTERS - 1
+		 uint8_t : its LEDs that get a brightness, one bit each
+		 const uint8_t * : 8 levels, 0 to LED_MAX_LEVEL, LED 0 first (may be
+		 NULL if Animated is 0)
 
  Returns
      none
 
  Description
-     Takes the 8 array values and writes them into the shift register one at a time
-		 At the very end, it will pulse the RCK pin as well, so that this function alone
-		 will turn the corresponding LEDs on/off
- Notes
-		 It is assumed that each array value is only either 1 or 0. 0 corresponds
-		 to the LED being ON, and 1 is OFF.
-****************************************************************************/
-void setLED (char LEDs[8]) {
-	for (int i = 0; i < 8; i++) {
-		int bit = 0;
-		//clears data pin 
-		HWREG(SHIFT_PORT + GPIO_O_DATA + ALL_BITS) &= ~SHIFT_DATA;
-		
-		/* if the input value was 1, sets the pin to HI
-		   if the input value was 0, sets the pin to LO 
-		
-			 setting the local variable "bit" to the value being read and writes it
-			 to the data pin to get pulsed 
-		*/
-		bit = LEDs[i];
-		
-		if (bit == 1) {
-			HWREG(SHIFT_PORT + GPIO_O_DATA + ALL_BITS) |= SHIFT_DATA;
-		}
-		else if (bit == 0) {
-			HWREG(SHIFT_PORT + GPIO_O_DATA + ALL_BITS) &= ~SHIFT_DATA;
+     turns the levels into bit planes and hands them to the refresh
+		 interrupt, starting it for the first animated LED and stopping it
+		 after the last
+ Notes
+		 the planes are written into the pair the interrupt is not showing,
+		 and swapped in with one byte write, so it never sends half of an
+		 update. Levels above LED_MAX_LEVEL show as LED_MAX_LEVEL
+****************************************************************************/
+void setLEDLevels (uint8_t Bank, uint8_t Animated, const uint8_t *pLevels) {
+	if (Bank >= LED_REGISTERS)
+		return;
+
+	uint8_t back = Ctx.front ^ 1;
+	LEDPlanes_t *pBack = &Ctx.planes[back];
+	*pBack = Ctx.planes[Ctx.front];
+
+	pBack->animated[Bank] = Animated;
+	for (uint8_t k = 0; k < LED_LEVEL_BITS; k++) {
+		pBack->bits[k][Bank] = 0;
+	}
+	for (uint8_t led = 0; led < 8; led++) {
+		if (!(Animated & BIT(led)))
+			continue;
+		uint8_t level = (pLevels[led] > LED_MAX_LEVEL) ? LED_MAX_LEVEL : pLevels[led];
+		for (uint8_t k = 0; k < LED_LEVEL_BITS; k++) {
+			if (level & BIT(k))
+				pBack->bits[k][Bank] |= BIT(led);
 		}
-		
-		// pulses SCK to send the single bit to shift register
-		SCKPulse();
 	}
-	
-	/* leaving the loop means it has gone through all 8 bits, so
-	   the shfit register is ready to write it to LEDs
-	*/
-	RCKPulse();
+	Ctx.front = back;
+
+	bool animated = false;
+	for (uint8_t bank = 0; bank < LED_REGISTERS; bank++) {
+		if (pBack->animated[bank])
+			animated = true;
+	}
+	if (animated && !Ctx.refreshing) {
+		startRefresh();
+	} else if (!animated && Ctx.refreshing) {
+		// back to on/off: the chain gets the LEDs as they are now
+		stopRefresh();
+		Ctx.known = false;
+		flushLEDs();
+	}
+}
+
+/****************************************************************************
+ Function
+     LEDRefreshISR
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     sends the chain with the next bit plane in place of the animated LEDs,
+		 and loads the interval of the plane after it
+ Notes
+		 the interval written here is taken up when the plane just sent ends
+		 (TAILD), so plane k shows for 2^k slots. One chain transfer a call,
+		 whatever the levels
+****************************************************************************/
+void LEDRefreshISR (void) {
+	HWREG(REFRESH_TIMER + TIMER_O_ICR) = TIMER_ICR_TATOCINT;
+
+	const LEDPlanes_t *pPlanes = &Ctx.planes[Ctx.front];
+	uint8_t plane = Ctx.plane;
+	uint8_t frame[LED_REGISTERS];
+
+	for (uint8_t i = 0; i < LED_REGISTERS; i++) {
+		uint8_t bank = LED_REGISTERS - 1 - i;
+		uint8_t lit = (Ctx.lit[bank] & ~pPlanes->animated[bank]) | pPlanes->bits[plane][bank];
+		frame[i] = (uint8_t)~lit;
+	}
+	ShiftBusSend(&LEDBus, frame, 1);
+
+	plane = (plane + 1) % LED_LEVEL_BITS;
+	Ctx.plane = plane;
+	HWREG(REFRESH_TIMER + TIMER_O_TAILR) = ((uint32_t)BAM_SLOT_CLOCKS << plane) - 1;
+}
+
+/****************************************************************************
+ Function
+     initRefreshTimer
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     sets Timer 2A up as a 32 bit periodic timer that loads a new interval
+		 at its next timeout, with its timeout interrupt enabled, but stopped
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void initRefreshTimer (void) {
+	HWREG(SYSCTL_RCGCTIMER) |= REFRESH_TIMER_DEC;
+	// kill time
+	HWREG(SYSCTL_RCGCTIMER);
+
+	HWREG(REFRESH_TIMER + TIMER_O_CTL) &= ~TIMER_CTL_TAEN;
+	HWREG(REFRESH_TIMER + TIMER_O_CFG) = TIMER_CFG_32_BIT_TIMER;
+	HWREG(REFRESH_TIMER + TIMER_O_TAMR) = TIMER_TAMR_TAMR_PERIOD | TIMER_TAMR_TAILD;
+	HWREG(REFRESH_TIMER + TIMER_O_IMR) |= TIMER_IMR_TATOIM;
+	HWREG(NVIC_EN0) = REFRESH_INT_BIT;
+}
+
+/****************************************************************************
+ Function
+     startRefresh
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     starts Timer 2A with plane 0's interval, plane 1's loaded for after it
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+void startRefresh (void) {
+	Ctx.plane = 0;
+	Ctx.refreshing = true;
+	HWREG(REFRESH_TIMER + TIMER_O_TAILR) = BAM_SLOT_CLOCKS - 1;
+	HWREG(REFRESH_TIMER + TIMER_O_ICR) = TIMER_ICR_TATOCINT;
+	HWREG(REFRESH_TIMER + TIMER_O_CTL) |= TIMER_CTL_TAEN;
+}
+
+/****************************************************************************
+ Function
+     stopRefresh
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     stops Timer 2A and clears a timeout that was still pending
+ Notes
+		 this function is a PRIVATE function
+		 the interrupt cannot be half way through a transfer here, since it
+		 runs to the end before this code gets the CPU back
+****************************************************************************/
+void stopRefresh (void) {
+	HWREG(REFRESH_TIMER + TIMER_O_CTL) &= ~TIMER_CTL_TAEN;
+	HWREG(REFRESH_TIMER + TIMER_O_ICR) = TIMER_ICR_TATOCINT;
+	Ctx.refreshing = false;
 }
 
 /****************************************************************************
@@ -186,27 +505,13 @@ void setLED (char LEDs[8]) {
 ****************************************************************************/
 #ifdef TEST 
 
-// array index with their corresponding LED's location
-#define Tier1 2
-#define Tier2 0
-#define Tier3 7
-#define Tier4 1
-#define Tier5 4
-#define Tier6 5
-#define pot 3
-
 int main(void) 
 { 
 	TERMIO_Init(); 
 	puts("\n\r in test harness for LEDs shift register\r\n");
 	
-	// 0 is On, 1 is Off
-
-	// Array index 6 is empty (no LED)
-	char test[8] =  {1,1,1,1,1,1,1,1};
-	test[Tier1] = 0;
-	test[pot] = 0;
 	LEDShiftRegInit();
-	setLED (test);
+	turnOnLEDs(LED_TIER1 | LED_POT);
+	flushLEDs();
 }
 #endif
@@ -7,12 +7,106 @@
 #ifndef LEDS_H
 #define LEDS_H
 
+#include <stdint.h>
+#include "ShiftBus.h"
+
+/* NOTES:
+
+	The LEDs are one bit each in a byte, 1 for on. turnOnLEDs, turnOffLEDs,
+	toggleLEDs and setLEDs only change a copy of the shift register kept in
+	memory; flushLEDs sends it, and only if it differs from what the shift
+	register already holds. RunDisarmFSM flushes once at the end of every
+	event, so an event that changes several LEDs costs one transfer, and one
+	that changes none costs nothing.
+
+	More LEDs go on more 595s chained after the first one: define
+	LED_REGISTERS for the whole project. Each 595 is a bank of 8 LEDs, bank
+	0 the one wired to the Tiva, which the functions above work on;
+	setLEDBank and getLEDBank reach the others. Each bank is marked dirty
+	on its own, and a flush only compares the dirty ones with what was
+	sent. When one has changed the whole chain is shifted: a 595 passes on
+	whatever it held as new bits come in, so stopping short of the end
+	would latch stale bits into the banks further out. A flush therefore
+	grows by under 2 uS a bank: 2.1 uS for one, 14.7 uS for 64 LEDs. The
+	whole chain goes out as one ShiftBus transfer, so LED_REGISTERS can be
+	at most SHIFT_BUS_MAX_BYTES; define that higher too for a longer chain.
+	A flush the shift bus drops leaves the banks dirty, and the next flush
+	sends them again.
+
+	Brightness
+	----------------------------------------
+	setLEDLevels gives some LEDs of a bank a brightness, 0 to LED_MAX_LEVEL,
+	instead of just on or off (LEDAnimation.c does this for its fades). As
+	long as any LED has one, Timer 2A runs bit angle modulation: the LEDs
+	go out as LED_LEVEL_BITS bit planes, plane k showing the bit k of each
+	level for 2^k slots of BAM_SLOT_US. LEDRefreshISR sends one plane per
+	interrupt, so it costs one chain transfer however many LEDs are lit;
+	on the host wave bench that is 2.3 uS, 4 times every 0.96 mS, about
+	1% of the CPU. The LEDs without a level keep following the bits of
+	setLEDs and the rest, but flushLEDs leaves the sending to the interrupt
+	then, so that only one of them ever drives the shift register.
+
+	Put LEDRefreshISR in the Timer 2A slot (interrupt 39) of the vector
+	table in the startup file. The host build has no timer interrupts, so
+	its harnesses call LEDRefreshISR themselves.
+*/
+
+// 595s in the LED chain
+#ifndef LED_REGISTERS
+#define LED_REGISTERS 1
+#endif
+#if LED_REGISTERS > SHIFT_BUS_MAX_BYTES
+#error "the LED chain does not fit in one ShiftBus transfer, define SHIFT_BUS_MAX_BYTES as LED_REGISTERS or more"
+#endif
+
+// brightness levels, 0 is off
+#define LED_LEVEL_BITS 4
+#define LED_MAX_LEVEL ((1 << LED_LEVEL_BITS) - 1)
+
+// the LED on each output of the shift register
+#define LED_TIER1 (1 << 2)
+#define LED_TIER2 (1 << 0)
+#define LED_TIER3 (1 << 7)
+#define LED_TIER4 (1 << 1)
+#define LED_TIER5 (1 << 4)
+#define LED_TIER6 (1 << 5)
+#define LED_POT (1 << 3)
+// output 6 has no LED
+
 // Public Function Prototypes
 
 // intializes the Tiva ports for LED usage
 void LEDShiftRegInit (void); 
 
-// turns LEDs on and off based on input array
-void setLED (char LEDs[8]); 
+// turns on the LEDs whose bits are set in Mask
+void turnOnLEDs (uint8_t Mask);
+
+// turns off the LEDs whose bits are set in Mask
+void turnOffLEDs (uint8_t Mask);
+
+// turns the LEDs whose bits are set in Mask the other way
+void toggleLEDs (uint8_t Mask);
+
+// turns on exactly the LEDs whose bits are set in Lit
+void setLEDs (uint8_t Lit);
+
+// returns the LEDs that are on, one bit each
+uint8_t getLEDs (void);
+
+// turns on exactly the LEDs of a bank whose bits are set in Lit
+void setLEDBank (uint8_t Bank, uint8_t Lit);
+
+// returns the LEDs of a bank that are on, one bit each
+uint8_t getLEDBank (uint8_t Bank);
+
+// sends the LEDs to the shift register if they have changed
+void flushLEDs (void);
+
+// gives the LEDs of a bank set in Animated the brightness in pLevels (one
+// per LED, LED 0 first); Animated 0 turns them back into on/off LEDs
+void setLEDLevels (uint8_t Bank, uint8_t Animated, const uint8_t *pLevels);
+
+// Timer 2A interrupt: shows the next bit plane of the brightness levels
+void LEDRefreshISR (void);
 
 #endif
@@ -21,6 +21,7 @@
 #include "termio.h"
 #include "PWMTiva.h"
 #include "ADCSWTrigger.h"
+#include "GameContext.h"
 
 #define clrScrn() 	printf("\x1b[2J")
 
@@ -51,13 +52,9 @@
 #define ZERO_DEGREES 			1400 
 #define MINUS_90_DEGREES 	750
 
-// Static variables to store the servo positions
-static double potZero = -1;
-static bool victory = false;
-static uint16_t key_servo_pos = ZERO_DEGREES;
-static uint16_t tower_servo_pos = ZERO_DEGREES;
-static uint16_t tower_rotate_servo_pos = ZERO_DEGREES;
-static uint16_t flag_servo_pos = ZERO_DEGREES;
+// The servo positions, the pot zero and the victory flag are kept in
+// ServosContext_t (see GameContext.h)
+#define Ctx (pGame->Servos)
 
 // Private functions
 void rotateServo(uint8_t channel, uint16_t position);
@@ -170,7 +167,7 @@ void unlockKeys(void) {
  Notes
 ****************************************************************************/
 void setVictory(bool state) {
-	victory = state;
+	Ctx.victory = state;
 }
 
 /****************************************************************************
@@ -185,7 +182,7 @@ void setVictory(bool state) {
  Notes
 ****************************************************************************/
 bool getVictory(void) {
-	return victory;
+	return Ctx.victory;
 }
 
 /****************************************************************************
@@ -200,8 +197,8 @@ bool getVictory(void) {
  Notes
 ****************************************************************************/
 void setPotZero(void) {
-	potZero = getPotValue();
-	victory = false;
+	Ctx.potZero = getPotValue();
+	Ctx.victory = false;
 }
 
 /****************************************************************************
@@ -216,7 +213,7 @@ void setPotZero(void) {
  Notes
 ****************************************************************************/
 double getPotZero(void) {
-	return potZero;
+	return Ctx.potZero;
 }
 
 /****************************************************************************
@@ -235,7 +232,9 @@ double getPotValue(void)
 	static double conversion = POT_HIGH / 4096; //Volts/point value
 	double Direct_pot = 0; //this variable will be used to store the direct readout value
 	double pot_val = 0;    //the pot value converted to volts
-	Direct_pot = (double) ADC0_InSeq3(); // reads pin value, cast as a double
+	uint16_t sample = ADC0_InSeq3(); // reads pin value
+	addEntropy(sample); // its noise seeds the passwords
+	Direct_pot = (double) sample; // cast as a double
 	pot_val = Direct_pot * conversion;   // convert pot value to volts and return the value
 	return pot_val;
 }
@@ -254,16 +253,16 @@ double getPotValue(void)
 void moveTower(double potValue) 
 {
 	// the initialization is undone
-	if (potZero == -1) 
+	if (Ctx.potZero == -1) 
 	{
 		printf("Error: PotZero not inititialized.");
 		return;
 	}
 	// High on Pot = Low on Motor
-	if (potZero > 1.5) 
+	if (Ctx.potZero > 1.5) 
 	{
 		printf("\n\r Game Type A\r\n");
-		uint16_t tower_servo_pos = (potZero - potValue) / (potZero - POT_LOW) * (TOWER_ZERO_DEGREES - TOWER_LOW) + TOWER_ZERO_DEGREES;
+		uint16_t tower_servo_pos = (Ctx.potZero - potValue) / (Ctx.potZero - POT_LOW) * (TOWER_ZERO_DEGREES - TOWER_LOW) + TOWER_ZERO_DEGREES;
 		printf("\n\r Pot val: %lf, Tower servo pos: %d \r\n", potValue, tower_servo_pos);
 		rotateServo(TOWER_SERVO, tower_servo_pos);
 	} 
@@ -271,7 +270,7 @@ void moveTower(double potValue)
 	else 
 	{
 		printf("\n\r Game Type B\r\n");
-		uint16_t tower_servo_pos = TOWER_ZERO_DEGREES - (potValue - potZero) / (POT_HIGH - potZero) * (TOWER_ZERO_DEGREES - TOWER_LOW);
+		uint16_t tower_servo_pos = TOWER_ZERO_DEGREES - (potValue - Ctx.potZero) / (POT_HIGH - Ctx.potZero) * (TOWER_ZERO_DEGREES - TOWER_LOW);
 		//uint16_t tower_servo_pos = (potValue - potZero) / (POT_HIGH - potZero) * (TOWER_HIGH - TOWER_ZERO_DEGREES) + TOWER_ZERO_DEGREES;
 		printf("\n\r Pot val: %lf, Tower servo pos: %d \r\n", potValue, tower_servo_pos);
 		rotateServo(TOWER_SERVO, tower_servo_pos);
@@ -302,10 +301,10 @@ void initializeServos(void)
   PWM_TIVA_SetFreq(50, 0);
   PWM_TIVA_SetFreq(50, 1);
 	// initialize the PWM pulse width for key, tower and flag motor
-  PWM_TIVA_SetPulseWidth(key_servo_pos, KEY_SERVO);
-	PWM_TIVA_SetPulseWidth(tower_rotate_servo_pos, TOWER_ROTATE_SERVO);
-	PWM_TIVA_SetPulseWidth(tower_servo_pos,TOWER_SERVO);
-	PWM_TIVA_SetPulseWidth(flag_servo_pos,FLAG_SERVO);
+  PWM_TIVA_SetPulseWidth(Ctx.key_servo_pos, KEY_SERVO);
+	PWM_TIVA_SetPulseWidth(Ctx.tower_rotate_servo_pos, TOWER_ROTATE_SERVO);
+	PWM_TIVA_SetPulseWidth(Ctx.tower_servo_pos,TOWER_SERVO);
+	PWM_TIVA_SetPulseWidth(Ctx.flag_servo_pos,FLAG_SERVO);
 }
 
 /****************************************************************************
@@ -343,26 +342,26 @@ void rotateServo(uint8_t channel, uint16_t position)
 		// if key servo motor is chosen
 		if (channel == KEY_SERVO) 
 		{
-			key_servo_pos = position;
-			PWM_TIVA_SetPulseWidth(key_servo_pos, KEY_SERVO);
+			Ctx.key_servo_pos = position;
+			PWM_TIVA_SetPulseWidth(Ctx.key_servo_pos, KEY_SERVO);
 		} 
 		// if tower rotate motor is chosen
 		else if (channel == TOWER_ROTATE_SERVO) 
 		{
-			tower_rotate_servo_pos = position;
-			PWM_TIVA_SetPulseWidth(tower_rotate_servo_pos,TOWER_ROTATE_SERVO);
+			Ctx.tower_rotate_servo_pos = position;
+			PWM_TIVA_SetPulseWidth(Ctx.tower_rotate_servo_pos,TOWER_ROTATE_SERVO);
 		} 
 		// if tower servo motor is chosen
 		else if (channel == TOWER_SERVO) 
 		{
-			tower_servo_pos = position;
-			PWM_TIVA_SetPulseWidth(tower_servo_pos,TOWER_SERVO);
+			Ctx.tower_servo_pos = position;
+			PWM_TIVA_SetPulseWidth(Ctx.tower_servo_pos,TOWER_SERVO);
 		} 
 		// if flag servo motor is chosen
 		else if (channel == FLAG_SERVO) 
 		{
-			flag_servo_pos = position;
-			PWM_TIVA_SetPulseWidth(flag_servo_pos,FLAG_SERVO);
+			Ctx.flag_servo_pos = position;
+			PWM_TIVA_SetPulseWidth(Ctx.flag_servo_pos,FLAG_SERVO);
 		}
 	}
 }
@@ -383,33 +382,33 @@ void rotateServoLeft(uint8_t channel) {
 	if (channel == KEY_SERVO) 
 	{
 		// if current key_servo_pos - 10 is still in the allowed range 
-		if (!(key_servo_pos - 10 < MINUS_90_DEGREES))
+		if (!(Ctx.key_servo_pos - 10 < MINUS_90_DEGREES))
 			// rotate key servo to the left by 10 
-			key_servo_pos = key_servo_pos - 10;
-		PWM_TIVA_SetPulseWidth(key_servo_pos, KEY_SERVO);
+			Ctx.key_servo_pos = Ctx.key_servo_pos - 10;
+		PWM_TIVA_SetPulseWidth(Ctx.key_servo_pos, KEY_SERVO);
 	} 
 	// if tower rotate motor is chosen
 	else if (channel == TOWER_ROTATE_SERVO) 
 	{
 		// if current tower rotate servo pos - 15 is still in the allowed range
-		if (!(tower_rotate_servo_pos - 15 < MINUS_90_DEGREES))
+		if (!(Ctx.tower_rotate_servo_pos - 15 < MINUS_90_DEGREES))
 			// rotate tower rotate servo to the left by 15
-			tower_rotate_servo_pos = tower_rotate_servo_pos - 15;
-		PWM_TIVA_SetPulseWidth(tower_rotate_servo_pos, TOWER_ROTATE_SERVO);
+			Ctx.tower_rotate_servo_pos = Ctx.tower_rotate_servo_pos - 15;
+		PWM_TIVA_SetPulseWidth(Ctx.tower_rotate_servo_pos, TOWER_ROTATE_SERVO);
 	} 
 	// if tower servo motor is chosen
 	else if (channel == TOWER_SERVO) {
-		if (!(tower_servo_pos - 2 < MINUS_90_DEGREES))
+		if (!(Ctx.tower_servo_pos - 2 < MINUS_90_DEGREES))
 			// rotate tower servo to the left by 2
-			tower_servo_pos = tower_servo_pos - 2;
-		PWM_TIVA_SetPulseWidth(tower_servo_pos, TOWER_SERVO);
+			Ctx.tower_servo_pos = Ctx.tower_servo_pos - 2;
+		PWM_TIVA_SetPulseWidth(Ctx.tower_servo_pos, TOWER_SERVO);
 	} 
 	// if flag servo motor is chosen
 	else if (channel == FLAG_SERVO) {
-		if (!(flag_servo_pos - 10 < MINUS_90_DEGREES))
+		if (!(Ctx.flag_servo_pos - 10 < MINUS_90_DEGREES))
 			// rotate flag servo to the left by 10
-			flag_servo_pos = flag_servo_pos - 10;
-		PWM_TIVA_SetPulseWidth(flag_servo_pos, FLAG_SERVO);
+			Ctx.flag_servo_pos = Ctx.flag_servo_pos - 10;
+		PWM_TIVA_SetPulseWidth(Ctx.flag_servo_pos, FLAG_SERVO);
 	}
 }
 
@@ -427,32 +426,55 @@ void rotateServoLeft(uint8_t channel) {
 void rotateServoRight(uint8_t channel) {
 	// if key servo motor is chosen
 	if (channel == KEY_SERVO) {
-		if (!(key_servo_pos + 10 > PLUS_90_DEGREES))
-			key_servo_pos = key_servo_pos + 10;
-		PWM_TIVA_SetPulseWidth(key_servo_pos, KEY_SERVO);
+		if (!(Ctx.key_servo_pos + 10 > PLUS_90_DEGREES))
+			Ctx.key_servo_pos = Ctx.key_servo_pos + 10;
+		PWM_TIVA_SetPulseWidth(Ctx.key_servo_pos, KEY_SERVO);
 	} 
 	// if tower rotate motor is chosen
 	else if (channel == TOWER_ROTATE_SERVO) {
-		if (!(tower_rotate_servo_pos + 15 > PLUS_90_DEGREES))
-			tower_rotate_servo_pos = tower_rotate_servo_pos + 15;
-		PWM_TIVA_SetPulseWidth(tower_rotate_servo_pos, TOWER_ROTATE_SERVO);
+		if (!(Ctx.tower_rotate_servo_pos + 15 > PLUS_90_DEGREES))
+			Ctx.tower_rotate_servo_pos = Ctx.tower_rotate_servo_pos + 15;
+		PWM_TIVA_SetPulseWidth(Ctx.tower_rotate_servo_pos, TOWER_ROTATE_SERVO);
 	} 
 	// if tower servo motor is chosen
 	else if (channel == TOWER_SERVO) {
-		if (!(tower_servo_pos + 2 > PLUS_90_DEGREES))
-			tower_servo_pos = tower_servo_pos + 2;
-		PWM_TIVA_SetPulseWidth(tower_servo_pos, TOWER_SERVO);
+		if (!(Ctx.tower_servo_pos + 2 > PLUS_90_DEGREES))
+			Ctx.tower_servo_pos = Ctx.tower_servo_pos + 2;
+		PWM_TIVA_SetPulseWidth(Ctx.tower_servo_pos, TOWER_SERVO);
 	} 
 	// if flag servo motor is chosen
 	else if (channel == FLAG_SERVO) {
-		if (!(flag_servo_pos + 10 > PLUS_90_DEGREES))
-			flag_servo_pos = flag_servo_pos + 10;
-		PWM_TIVA_SetPulseWidth(flag_servo_pos, FLAG_SERVO);
+		if (!(Ctx.flag_servo_pos + 10 > PLUS_90_DEGREES))
+			Ctx.flag_servo_pos = Ctx.flag_servo_pos + 10;
+		PWM_TIVA_SetPulseWidth(Ctx.flag_servo_pos, FLAG_SERVO);
 	}
 }
 
 
 
+/****************************************************************************
+ Function
+     InitServosContext
+ Parameters
+     ServosContext_t *pContext : the context to set up
+ Returns
+     void
+ Description
+     Sets the power on values of this module's variables: every servo at
+     zero degrees and the pot not zeroed yet
+ Notes
+     Called by GameContext_Init
+****************************************************************************/
+void InitServosContext(ServosContext_t *pContext)
+{
+	pContext->potZero = -1;
+	pContext->victory = false;
+	pContext->key_servo_pos = ZERO_DEGREES;
+	pContext->tower_servo_pos = ZERO_DEGREES;
+	pContext->tower_rotate_servo_pos = ZERO_DEGREES;
+	pContext->flag_servo_pos = ZERO_DEGREES;
+}
+
 #ifdef TEST
 /* Test Harness for testing the servo motor module */
 int main(void)
@@ -468,52 +490,53 @@ int main(void)
 	puts("\rStarting Servo Test \r");
 	printf("%s %s\n",__TIME__, __DATE__);
 	printf("\n\r\n");
+	GameContext_Init(pGame);
   initializeServos();
 	while (true) {
 		char input = getchar();
 		switch (input) {
 			case 'a':
 				rotateServoLeft(TOWER_SERVO);
-				printf("Servo Position is %d\r\n", tower_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.tower_servo_pos);
 				break;
 			
 			case 's':
 				rotateServoRight(TOWER_SERVO);
-				printf("Servo Position is %d\r\n", tower_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.tower_servo_pos);
 				break;
 			
 			case 'q':
 				rotateServoLeft(FLAG_SERVO);
-				printf("Servo Position is %d\r\n", flag_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.flag_servo_pos);
 				break;
 			
 			case 'w':
 				rotateServoRight(FLAG_SERVO);
-				printf("Servo Position is %d\r\n", flag_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.flag_servo_pos);
 				break;
 			
 			case 'e':
 				lockKeys();
 				printf("Locking Keys...\r\n");
-				printf("Servo Position is %d\r\n", key_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.key_servo_pos);
 				break;
 			
 			case 'r':
 				unlockKeys();
 				printf("Unlocking Keys...\r\n");
-				printf("Servo Position is %d\r\n", key_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.key_servo_pos);
 				break;
 			
 			case 't':
 				raiseFlag();
 				printf("Raising Flag...\r\n");
-				printf("Servo Position is %d\r\n", flag_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.flag_servo_pos);
 				break;
 			
 			case 'y':
 				lowerFlag();
 				printf("Lowering Flag...\r\n");
-				printf("Servo Position is %d\r\n", flag_servo_pos);
+				printf("Servo Position is %d\r\n", Ctx.flag_servo_pos);
 				break;
 			
 			case 'f':
@@ -521,9 +544,9 @@ int main(void)
 				while (true) {
 					rotateServoRight(TOWER_ROTATE_SERVO);
 
-					printf("Servo Position is %d\r\n", tower_rotate_servo_pos);
+					printf("Servo Position is %d\r\n", Ctx.tower_rotate_servo_pos);
 					rotateServoLeft(TOWER_ROTATE_SERVO);
-					printf("Servo Position is %d\r\n", tower_rotate_servo_pos);
+					printf("Servo Position is %d\r\n", Ctx.tower_rotate_servo_pos);
 				}
 				break;
 		}
@@ -1,5 +1,7 @@
 #ifndef SERVOS_H
 #define SERVOS_H
+
+#include <stdbool.h>
 /****************************************************************************
  Module
    Servos.h
@@ -0,0 +1,183 @@
+/****************************************************************************
+ Module
+   ShiftBus.c
+
+ Description
+   This file drives the 74HC595 shift registers: the SCK and RCK pulses and
+	 the bit loop that the LCD and LED modules used to carry a copy of each.
+	 Which port and pins a chain is on is passed in a ShiftBus_t, and the
+	 transfers of every chain go out one after the other from one queue.
+****************************************************************************/
+#include "ShiftBus.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_sysctl.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/gpio.h"
+#include "ES_Port.h"
+#include "helperFunctions.h"
+#include "GameContext.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// shortest SCK and RCK pulse the 74HC595 takes at 4.5V
+#define SR_PULSE_NS 20
+
+/* the data register address with bits 9:2 set for the bus pins only: a
+	 write there changes those three pins and leaves the rest of the port
+	 alone, so a pin change is one write instead of a read and a write
+*/
+#define PINS_ADDRESS(pBus) ((pBus)->Port + GPIO_O_DATA + \
+		(((pBus)->Data | (pBus)->SCK | (pBus)->RCK) << 2))
+
+// this module's part of the running station's context
+#define Ctx (pGame->ShiftBus)
+
+// Private Function Prototypes
+void shiftOut (const ShiftBus_t *pBus, const uint8_t *pFrames, uint8_t Count);
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ShiftBusInit
+
+ Parameters
+     const ShiftBus_t * : the chain
+
+ Returns
+     none
+
+ Description
+     turns on the port, makes the data, SCK and RCK pins outputs and writes
+		 them LO (good for pulsing)
+ Notes
+		 also starts the cycle counter that times the pulses
+****************************************************************************/
+void ShiftBusInit (const ShiftBus_t *pBus) {
+	initCycleCounter();
+
+	HWREG(SYSCTL_RCGCGPIO) |= pBus->PortDec;
+	// kill time
+	HWREG(SYSCTL_RCGCGPIO);
+	HWREG(pBus->Port + GPIO_O_DEN) |= (pBus->Data | pBus->SCK | pBus->RCK);
+	HWREG(pBus->Port + GPIO_O_DIR) |= (pBus->Data | pBus->SCK | pBus->RCK);
+	HWREG(PINS_ADDRESS(pBus)) = 0;
+}
+
+/****************************************************************************
+ Function
+     ShiftBusSend
+
+ Parameters
+     const ShiftBus_t * : the chain
+		 const uint8_t * : the frames, pBus->Length bytes each
+		 uint8_t : how many frames
+
+ Returns
+     bool, false if the transfer was dropped
+
+ Description
+     puts the frames at the end of the queue. If no send is under way, it
+		 then shifts out the transfers in the queue one after the other,
+		 including any that interrupts queue meanwhile, until it is empty;
+		 otherwise the send under way takes these frames when its own
+		 transfer is done
+ Notes
+		 safe to call from an interrupt. A transfer of more than
+		 SHIFT_BUS_MAX_BYTES, or one that finds the queue full, is dropped
+		 and counted in Lost
+****************************************************************************/
+bool ShiftBusSend (const ShiftBus_t *pBus, const uint8_t *pFrames, uint8_t Count) {
+	uint16_t size = (uint16_t)Count * pBus->Length;
+	bool sending;
+
+	EnterCritical();
+	if ((size > SHIFT_BUS_MAX_BYTES) || (Ctx.Count >= SHIFT_BUS_QUEUE_SIZE)) {
+		Ctx.Lost++;
+		ExitCritical();
+		return false;
+	}
+	ShiftTransfer_t *pTransfer = &Ctx.Queue[(Ctx.Head + Ctx.Count) % SHIFT_BUS_QUEUE_SIZE];
+	pTransfer->pBus = pBus;
+	pTransfer->Count = Count;
+	memcpy(pTransfer->Bytes, pFrames, size);
+	Ctx.Count++;
+	sending = Ctx.Sending;
+	Ctx.Sending = true;
+	ExitCritical();
+
+	if (sending)
+		return true; // the send this interrupted shifts it out next
+
+	for (;;) {
+		pTransfer = &Ctx.Queue[Ctx.Head];
+		shiftOut(pTransfer->pBus, pTransfer->Bytes, pTransfer->Count);
+
+		EnterCritical();
+		Ctx.Head = (Ctx.Head + 1) % SHIFT_BUS_QUEUE_SIZE;
+		Ctx.Count--;
+		if (Ctx.Count == 0) {
+			Ctx.Sending = false;
+			ExitCritical();
+			return true;
+		}
+		ExitCritical();
+	}
+}
+
+/****************************************************************************
+ Function
+     shiftOut
+
+ Parameters
+     const ShiftBus_t * : the chain
+		 const uint8_t * : the frames, pBus->Length bytes each
+		 uint8_t : how many frames
+
+ Returns
+     none
+
+ Description
+     for every frame, shifts its bytes in one bit at a time (the data pin
+		 set, then SCK HI and back LO), then pulses RCK so the outputs of
+		 the whole chain change together
+ Notes
+		 this function is a PRIVATE function
+		 the data pin changes on the same write that takes SCK LO, as the
+		 595 reads it on the rising edge only; every rising edge is held the
+		 595's minimum pulse width
+****************************************************************************/
+void shiftOut (const ShiftBus_t *pBus, const uint8_t *pFrames, uint8_t Count) {
+	uint32_t pins = PINS_ADDRESS(pBus);
+	uint8_t data = 0;
+
+	for (uint8_t frame = 0; frame < Count; frame++) {
+		for (uint8_t i = 0; i < pBus->Length; i++) {
+			uint8_t value = *pFrames++;
+
+			for (uint8_t bit = 0; bit < 8; bit++) {
+				uint8_t mask = pBus->MSBFirst ? (0x80 >> bit) : (0x01 << bit);
+
+				data = (value & mask) ? pBus->Data : 0;
+				// data with SCK LO, then SCK HI to shift it in
+				HWREG(pins) = data;
+				HWREG(pins) = data | pBus->SCK;
+				delayNs(SR_PULSE_NS);
+			}
+		}
+
+		/* leaving the loop means it has gone through all the bits, so
+			 the chain is ready to write them to its outputs
+		*/
+		HWREG(pins) = data;
+		HWREG(pins) = data | pBus->RCK;
+		delayNs(SR_PULSE_NS);
+		HWREG(pins) = data;
+	}
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+ 
+  Header file for ShiftBus.c -- 74HC595 shift registers on three GPIO pins
+
+ ****************************************************************************/
+
+#ifndef SHIFT_BUS_H
+#define SHIFT_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* NOTES:
+
+	Every shift register chain on the board (the LCD's on port C, the
+	LEDs' on port A) is a ShiftBus_t: its port, its data, SCK and RCK pins
+	and how many 595s are chained. The module that owns the chain keeps
+	its ShiftBus_t const, and hands ShiftBusSend the frames to latch.
+
+	A frame is one byte per register in the chain, the byte for the
+	register furthest from the Tiva first. ShiftBusSend sends all the
+	frames it is given back to back, pulsing RCK after each one, so a
+	device that needs a sequence of outputs (the LCD's E pulse) asks for
+	all of it at once.
+
+	Every transfer goes through one queue, for all the chains. A
+	ShiftBusSend that finds nobody sending shifts the queue out itself,
+	transfer after transfer, until it is empty. One made from an interrupt
+	that came in during a transfer (the LED refresh in the middle of an
+	LCD nibble) only queues its frames, and the sender it interrupted
+	shifts them out as soon as its own transfer is done. So no two
+	transfers ever mix their edges, and an interrupt never waits for one.
+	A transfer that finds the queue full, or that is longer than
+	SHIFT_BUS_MAX_BYTES, is dropped and counted in Lost, and ShiftBusSend
+	returns false so the caller can send it again later.
+*/
+
+// transfers the queue holds
+#define SHIFT_BUS_QUEUE_SIZE 4
+// bytes a transfer can carry, frames times 595s in the chain
+#ifndef SHIFT_BUS_MAX_BYTES
+#define SHIFT_BUS_MAX_BYTES 16
+#endif
+
+// one chain of shift registers
+typedef struct {
+	uint32_t Port; // GPIO port base, GPIO_PORTx_BASE
+	uint32_t PortDec; // its SYSCTL_RCGCGPIO_Rx bit
+	uint8_t Data; // the pins, GPIO_PIN_x
+	uint8_t SCK;
+	uint8_t RCK;
+	uint8_t Length; // 595s in the chain
+	bool MSBFirst; // bit 7 of a byte goes out first, else bit 0
+} ShiftBus_t;
+
+// one transfer waiting in the queue
+typedef struct {
+	const ShiftBus_t *pBus;
+	uint8_t Count; // frames
+	uint8_t Bytes[SHIFT_BUS_MAX_BYTES];
+} ShiftTransfer_t;
+
+// Public Function Prototypes
+
+// makes the bus pins outputs, LO
+void ShiftBusInit (const ShiftBus_t *pBus);
+
+// queues Count frames of pBus->Length bytes, and shifts out and latches
+// them along with the rest of the queue unless a send is already under way;
+// false if the transfer was dropped
+bool ShiftBusSend (const ShiftBus_t *pBus, const uint8_t *pFrames, uint8_t Count);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef SLOTDETECTOR_H
 #define SLOTDETECTOR_H
 
+#include <stdbool.h>
+
 /****************************************************************************
  Module
    SlotDetector.h
@@ -7,6 +7,8 @@
 #ifndef TAPESENSOR_H
 #define TAPESENSOR_H
 
+#include <stdbool.h>
+
 // Public Function Prototypes
 
 //initializes port F4 to read the output from the three tape sensors 
@@ -9,6 +9,10 @@
    This is a delay function for implementing a simple service under the 
    Gen2 Events and Services Framework.
 
+	 It also has the short delays, counted on the Cortex-M4 cycle counter
+	 (DWT CYCCNT) so that a pulse lasts the nS asked for whatever the
+	 compiler does with the loop around it.
+
  NOTES: **********************************************************************			
  *****************************************************************************
  
@@ -17,6 +21,23 @@
 /* include header files for this module 
 */
 #include "helperFunctions.h"
+#ifdef HOST_SIM
+#include "HostSim.h"
+#endif
+
+/*----------------------------- Module Defines ----------------------------*/
+// the cycle counter lives in the DWT, which only runs with trace enabled
+#define DEMCR 0xE000EDFC // debug exception and monitor control
+#define DEMCR_TRCENA 0x01000000
+#define DWT_CTRL 0xE0001000
+#define DWT_CTRL_CYCCNTENA 0x00000001
+#define DWT_CYCCNT 0xE0001004
+
+// clocks for a time in nS, rounded up
+#define NS_TO_CLOCKS(ns) ((uint32_t)(((uint64_t)(ns) * CLOCKS_PER_US + 999) / 1000))
+
+/*---------------------------- Module Functions ---------------------------*/
+static void delayClocks (uint32_t clocks);
 
 /*------------------------------ Module Function ------------------------------*/
 /****************************************************************************
@@ -36,14 +57,170 @@
 
 ****************************************************************************/
 void wait (int delay) { 
-	// initialize local variable time_start and time
-	unsigned int time_start = ES_Timer_GetTime(); 
-	unsigned int time = ES_Timer_GetTime();
+	// initialize local variable time_start
+	uint16_t time_start = ES_Timer_GetTime(); 
 	
-	// loop until current time is larger than start time plus delay time
-	while (time < time_start + delay) 
+#ifdef HOST_SIM
+	// nothing else runs while this spins, so the host jumps the clock to
+	// where the loop below would end instead of simulating every pass; with
+	// real time pacing a skip sleeps only part of the way, so skip again
+	// until the delay is over
+	while ((uint16_t)(ES_Timer_GetTime() - time_start) < delay)
+		HostSim_SkipTicks(delay - (uint16_t)(ES_Timer_GetTime() - time_start));
+	return;
+#endif
+	// loop until the ticks since the start reach the delay time
+	// (counted in 16 bits so the wrap of the tick counter is harmless)
+	while ((uint16_t)(ES_Timer_GetTime() - time_start) < delay) 
 	{
 		HWREG(SYSCTL_RCGCGPIO);
-		time = ES_Timer_GetTime();
 	}
 }
+
+/****************************************************************************
+ Function
+     initCycleCounter
+
+ Parameters
+     none
+
+ Returns
+     void
+
+ Description
+     turns on trace and the DWT cycle counter
+ Notes
+		 the modules that use the short delays call this from their init
+		 functions; calling it again does nothing more
+****************************************************************************/
+void initCycleCounter (void) {
+	HWREG(DEMCR) |= DEMCR_TRCENA;
+	HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+/****************************************************************************
+ Function
+     getCycleCount
+
+ Parameters
+     none
+
+ Returns
+     uint32_t : CPU clocks counted so far (wraps every 107 S at 40MHz)
+
+ Description
+     reads the cycle counter
+ Notes
+		 the host simulation answers with its own clock
+****************************************************************************/
+uint32_t getCycleCount (void) {
+	return HWREG(DWT_CYCCNT);
+}
+
+/****************************************************************************
+ Function
+     delayNs
+
+ Parameters
+     uint32_t : delay time in nS
+
+ Returns
+     void
+
+ Description
+     waits until at least that many nS have gone by
+		 
+ Notes
+		 at 40MHz a clock is 25 nS, so anything up to 25 nS is one clock
+****************************************************************************/
+void delayNs (uint32_t ns) {
+	delayClocks(NS_TO_CLOCKS(ns));
+}
+
+/****************************************************************************
+ Function
+     delayUs
+
+ Parameters
+     uint32_t : delay time in uS
+
+ Returns
+     void
+
+ Description
+     waits until at least that many uS have gone by
+		 
+ Notes
+
+****************************************************************************/
+void delayUs (uint32_t us) {
+	delayClocks(us * CLOCKS_PER_US);
+}
+
+/****************************************************************************
+ Function
+     getDeadline
+
+ Parameters
+     uint32_t : time from now in nS
+
+ Returns
+     uint32_t : the cycle count at that time
+
+ Description
+     for waiting on something else and a time limit together, with
+		 isDeadlinePast
+ Notes
+		 deadlines more than 53 S away cannot be told from ones in the past
+****************************************************************************/
+uint32_t getDeadline (uint32_t ns) {
+	return getCycleCount() + NS_TO_CLOCKS(ns);
+}
+
+/****************************************************************************
+ Function
+     isDeadlinePast
+
+ Parameters
+     uint32_t : a cycle count from getDeadline
+
+ Returns
+     bool : true once the cycle counter has reached it
+
+ Description
+     compares the cycle counter with the deadline, across the wrap
+ Notes
+		 each call takes time on the host too, so polling it ends there as
+		 well, but not in an event checker while the host holds the clock
+****************************************************************************/
+bool isDeadlinePast (uint32_t deadline) {
+	return ((int32_t)(getCycleCount() - deadline) >= 0);
+}
+
+/****************************************************************************
+ Function
+     delayClocks
+
+ Parameters
+     uint32_t : delay time in CPU clocks
+
+ Returns
+     void
+
+ Description
+     spins on the cycle counter until the clocks have gone by
+ Notes
+		 this function is a PRIVATE function
+****************************************************************************/
+static void delayClocks (uint32_t clocks) {
+#ifdef HOST_SIM
+	// as in wait(), the host charges the time at once instead of spinning
+	HostSim_Charge(clocks);
+	return;
+#endif
+	uint32_t start = getCycleCount();
+
+	// unsigned difference, so the wrap of the counter is harmless
+	while ((getCycleCount() - start) < clocks)
+		;
+}
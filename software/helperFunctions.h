@@ -5,6 +5,9 @@
 
  ****************************************************************************/
  
+#ifndef HELPER_FUNCTIONS_H
+#define HELPER_FUNCTIONS_H
+
  /*----------------------------- Include Files -----------------------------*/
 /* include header files for any machines at the
    next lower level in the hierarchy that are sub-machines to this machine
@@ -22,6 +25,29 @@
 #include "termio.h"
 #include "driverlib/gpio.h"
 
+// the CPU clock main sets up (40MHz), in clocks per uS
+#define CLOCKS_PER_US 40
+
 // Public Function Prototype
 // this is a wait(delay) function
 void wait (int delay); 
+
+// starts the Cortex-M4 cycle counter (DWT CYCCNT), safe to call again
+void initCycleCounter (void);
+
+// returns the cycle counter, one count per CPU clock
+uint32_t getCycleCount (void);
+
+// waits at least the given nS, to the nearest clock
+void delayNs (uint32_t ns);
+
+// waits at least the given uS, to the nearest clock
+void delayUs (uint32_t us);
+
+// returns the cycle count ns nS from now, for isDeadlinePast
+uint32_t getDeadline (uint32_t ns);
+
+// true once the cycle counter has reached the deadline
+bool isDeadlinePast (uint32_t deadline);
+
+#endif
@@ -0,0 +1,77 @@
+/****************************************************************************
+
+  Host replacement for the Tiva ES_Port.h
+  based on the Gen2 Events and Services Framework
+
+  Only used by the host simulation build (see host/HostHAL.h). The timer
+  rates keep the names and values of the Tiva port (SysTick reload counts
+  at 40MHz) so that the firmware sources compile unchanged.
+
+ ****************************************************************************/
+
+#ifndef ES_PORT_H
+#define ES_PORT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "termio.h"
+
+// bit definitions used throughout the firmware
+#define BIT0HI 0x00000001
+#define BIT1HI 0x00000002
+#define BIT2HI 0x00000004
+#define BIT3HI 0x00000008
+#define BIT4HI 0x00000010
+#define BIT5HI 0x00000020
+#define BIT6HI 0x00000040
+#define BIT7HI 0x00000080
+#define BIT8HI 0x00000100
+#define BIT9HI 0x00000200
+#define BIT10HI 0x00000400
+#define BIT11HI 0x00000800
+#define BIT12HI 0x00001000
+#define BIT13HI 0x00002000
+#define BIT14HI 0x00004000
+#define BIT15HI 0x00008000
+
+#define BIT0LO (~BIT0HI)
+#define BIT1LO (~BIT1HI)
+#define BIT2LO (~BIT2HI)
+#define BIT3LO (~BIT3HI)
+#define BIT4LO (~BIT4HI)
+#define BIT5LO (~BIT5HI)
+#define BIT6LO (~BIT6HI)
+#define BIT7LO (~BIT7HI)
+#define BIT8LO (~BIT8HI)
+#define BIT9LO (~BIT9HI)
+#define BIT10LO (~BIT10HI)
+#define BIT11LO (~BIT11HI)
+#define BIT12LO (~BIT12HI)
+#define BIT13LO (~BIT13HI)
+#define BIT14LO (~BIT14HI)
+#define BIT15LO (~BIT15HI)
+
+// there are no interrupts on the host, so critical regions are empty
+#define EnterCritical()
+#define ExitCritical()
+
+// rates for the timer tick, in 40MHz clocks per tick like the Tiva port
+typedef enum { ES_Timer_RATE_OFF = (0),
+               ES_Timer_RATE_500uS = 20000,
+               ES_Timer_RATE_1mS = 40000,
+               ES_Timer_RATE_2mS = 80000,
+               ES_Timer_RATE_4mS = 160000,
+               ES_Timer_RATE_5mS = 200000,
+               ES_Timer_RATE_8mS = 320000,
+               ES_Timer_RATE_10mS = 400000,
+               ES_Timer_RATE_16mS = 640000,
+               ES_Timer_RATE_32mS = 1280000
+} TimerRate_t;
+
+// Public Function Prototypes
+void _HW_Timer_Init(const TimerRate_t Rate);
+bool _HW_Process_Pending_Ints(void);
+uint16_t _HW_GetTickCount(void);
+
+#endif /* ES_PORT_H */
@@ -0,0 +1,483 @@
+/****************************************************************************
+ Module
+   HostFramework.c
+
+ Revision
+   1.0.1
+
+ Description
+   Host replacement for ES_Framework.c. Runs the services listed in
+	 ES_Configure.h the same way the Tiva framework does: one queue per
+	 service, the highest numbered service with a waiting event runs first,
+	 and the event checkers are polled whenever every queue is empty.
+	 Every post is also handed to the event trace (EventTrace.h).
+
+ Notes
+   The service tables are built from the SERV_n_ macros in ES_Configure.h,
+	 so the host build needs no changes to the configuration.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "EventTrace.h"
+#include "HostSim.h"
+#include "HostStation.h"
+
+#ifdef TEST
+#include <time.h>
+#include "HostHAL.h"
+#include "DisarmFSM.h"
+#endif
+
+/*----------------------------- Module Defines ----------------------------*/
+// this module's part of the running station
+#define Ctx (pStation->Framework)
+
+/*---------------------------- Module Types -------------------------------*/
+typedef bool InitFunc_t(uint8_t Priority);
+typedef ES_Event RunFunc_t(ES_Event ThisEvent);
+
+/*---------------------------- Module Functions ---------------------------*/
+static ES_Return_t runLoop(bool Forever, uint32_t Until);
+static ES_Return_t runServices(void);
+static bool dequeue(uint8_t WhichService, ES_Event *pEvent);
+static uint8_t highestReady(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static InitFunc_t * const ServInit[] = {
+	SERV_0_INIT,
+#if NUM_SERVICES > 1
+	SERV_1_INIT,
+#endif
+#if NUM_SERVICES > 2
+	SERV_2_INIT,
+#endif
+#if NUM_SERVICES > 3
+	SERV_3_INIT,
+#endif
+#if NUM_SERVICES > 4
+	SERV_4_INIT,
+#endif
+#if NUM_SERVICES > 5
+	SERV_5_INIT,
+#endif
+#if NUM_SERVICES > 6
+	SERV_6_INIT,
+#endif
+#if NUM_SERVICES > 7
+	SERV_7_INIT,
+#endif
+#if NUM_SERVICES > 8
+	SERV_8_INIT,
+#endif
+#if NUM_SERVICES > 9
+	SERV_9_INIT,
+#endif
+#if NUM_SERVICES > 10
+	SERV_10_INIT,
+#endif
+#if NUM_SERVICES > 11
+	SERV_11_INIT,
+#endif
+#if NUM_SERVICES > 12
+	SERV_12_INIT,
+#endif
+#if NUM_SERVICES > 13
+	SERV_13_INIT,
+#endif
+#if NUM_SERVICES > 14
+	SERV_14_INIT,
+#endif
+#if NUM_SERVICES > 15
+	SERV_15_INIT,
+#endif
+};
+
+static RunFunc_t * const ServRun[] = {
+	SERV_0_RUN,
+#if NUM_SERVICES > 1
+	SERV_1_RUN,
+#endif
+#if NUM_SERVICES > 2
+	SERV_2_RUN,
+#endif
+#if NUM_SERVICES > 3
+	SERV_3_RUN,
+#endif
+#if NUM_SERVICES > 4
+	SERV_4_RUN,
+#endif
+#if NUM_SERVICES > 5
+	SERV_5_RUN,
+#endif
+#if NUM_SERVICES > 6
+	SERV_6_RUN,
+#endif
+#if NUM_SERVICES > 7
+	SERV_7_RUN,
+#endif
+#if NUM_SERVICES > 8
+	SERV_8_RUN,
+#endif
+#if NUM_SERVICES > 9
+	SERV_9_RUN,
+#endif
+#if NUM_SERVICES > 10
+	SERV_10_RUN,
+#endif
+#if NUM_SERVICES > 11
+	SERV_11_RUN,
+#endif
+#if NUM_SERVICES > 12
+	SERV_12_RUN,
+#endif
+#if NUM_SERVICES > 13
+	SERV_13_RUN,
+#endif
+#if NUM_SERVICES > 14
+	SERV_14_RUN,
+#endif
+#if NUM_SERVICES > 15
+	SERV_15_RUN,
+#endif
+};
+
+static const uint8_t ServQueueSize[] = {
+	SERV_0_QUEUE_SIZE,
+#if NUM_SERVICES > 1
+	SERV_1_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 2
+	SERV_2_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 3
+	SERV_3_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 4
+	SERV_4_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 5
+	SERV_5_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 6
+	SERV_6_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 7
+	SERV_7_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 8
+	SERV_8_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 9
+	SERV_9_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 10
+	SERV_10_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 11
+	SERV_11_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 12
+	SERV_12_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 13
+	SERV_13_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 14
+	SERV_14_QUEUE_SIZE,
+#endif
+#if NUM_SERVICES > 15
+	SERV_15_QUEUE_SIZE,
+#endif
+};
+
+// the queues of each station are kept in HostFrameworkContext_t
+// (see HostStation.h)
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_Initialize
+
+ Parameters
+     TimerRate_t : the rate at which to run the framework timers
+
+ Returns
+     ES_Return_t : FailedInit if any service failed to initialize
+
+ Description
+     empties the queues, starts the timers and initializes each service in
+		 turn, lowest number first
+ Notes
+
+****************************************************************************/
+ES_Return_t ES_Initialize(TimerRate_t NewRate) {
+	uint16_t offset = 0;
+
+	Ctx.Ready = 0;
+	for (uint8_t i = 0; i < NUM_SERVICES; i++) {
+		Ctx.Queues[i].pBuffer = &Ctx.QueuePool[offset];
+		Ctx.Queues[i].Size = ServQueueSize[i];
+		Ctx.Queues[i].Head = 0;
+		Ctx.Queues[i].Count = 0;
+		offset += ServQueueSize[i];
+	}
+
+	ES_Timer_Init(NewRate);
+
+	for (uint8_t i = 0; i < NUM_SERVICES; i++) {
+		if (ServInit[i](i) != true)
+			return FailedInit;
+	}
+	return Success;
+}
+
+/****************************************************************************
+ Function
+     ES_Run
+
+ Parameters
+     none
+
+ Returns
+     ES_Return_t : FailedRun if a service returned ES_ERROR
+
+ Description
+     the main loop. Runs the highest priority service with a waiting event
+		 until every queue is empty, then polls the event checkers
+ Notes
+     only returns on an error
+****************************************************************************/
+ES_Return_t ES_Run(void) {
+	return runLoop(true, 0);
+}
+
+/****************************************************************************
+ Function
+     HostSim_RunUntil
+
+ Parameters
+     uint32_t : the tick count to stop at
+
+ Returns
+     ES_Return_t : Success once the tick count is reached, FailedRun if a
+		 service returned ES_ERROR first
+
+ Description
+     the same loop as ES_Run, for scripts that need to change the inputs
+		 at set times
+ Notes
+
+****************************************************************************/
+ES_Return_t HostSim_RunUntil(uint32_t Tick) {
+	return runLoop(false, Tick);
+}
+
+/****************************************************************************
+ Function
+     HostSim_RunPending
+
+ Parameters
+     none
+
+ Returns
+     ES_Return_t : Success once every queue is empty, FailedRun if a
+		 service returned ES_ERROR first
+
+ Description
+     runs the services until nothing is left to do, without polling the
+		 event checkers or skipping ahead
+ Notes
+     timers that expire while the services run are still handled
+****************************************************************************/
+ES_Return_t HostSim_RunPending(void) {
+	return runServices();
+}
+
+/****************************************************************************
+ Function
+     HostSim_SetStimulus
+
+ Parameters
+     HostStimulus_t * : what to poll in place of the event checkers, NULL
+		 for the event checkers
+
+ Returns
+     none
+
+ Description
+     lets a replay post its recorded stimuli at the same point of the loop
+		 where the event checkers would have posted them
+ Notes
+     events posted by pSource are recorded as stimuli
+****************************************************************************/
+void HostSim_SetStimulus(HostStimulus_t *pSource) {
+	Ctx.pStimulus = pSource;
+}
+
+/****************************************************************************
+ Function
+     ES_PostToService
+
+ Parameters
+     uint8_t : the service to post to
+		 ES_Event : the event to post
+
+ Returns
+     bool, false if the service does not exist or its queue is full
+
+ Description
+     adds an event to the end of a service's queue
+ Notes
+
+****************************************************************************/
+bool ES_PostToService(uint8_t WhichService, ES_Event TheEvent) {
+	if (WhichService >= NUM_SERVICES)
+		return false;
+
+	HostQueue_t *pQueue = &Ctx.Queues[WhichService];
+	if (pQueue->Count >= pQueue->Size) {
+		printf("ES_PostToService: queue %d full\r\n", WhichService);
+		return false;
+	}
+
+	pQueue->pBuffer[(pQueue->Head + pQueue->Count) % pQueue->Size] = TheEvent;
+	pQueue->Count++;
+	Ctx.Ready |= (1 << WhichService);
+	EventTrace_Record(WhichService, TheEvent, HostSim_GetTicks(), Ctx.InCheckers);
+	return true;
+}
+
+/****************************************************************************
+ Function
+     ES_PostAll
+
+ Parameters
+     ES_Event : the event to post
+
+ Returns
+     bool, false if any of the posts failed
+
+ Description
+     posts an event to every service
+ Notes
+
+****************************************************************************/
+bool ES_PostAll(ES_Event ThisEvent) {
+	bool ReturnVal = true;
+
+	for (uint8_t i = 0; i < NUM_SERVICES; i++) {
+		if (ES_PostToService(i, ThisEvent) != true)
+			ReturnVal = false;
+	}
+	return ReturnVal;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// runs services and event checkers, skipping the clock ahead when idle
+static ES_Return_t runLoop(bool Forever, uint32_t Until) {
+	while (Forever || ((int32_t)(HostSim_GetTicks() - Until) < 0)) {
+		if (runServices() != Success)
+			return FailedRun;
+		// all the queues are empty, so look for new events. The checkers run
+		// on a held clock, so a stimulus source standing in for them leaves
+		// the timing alone
+		Ctx.InCheckers = true;
+		HostSim_HoldClock(true);
+		if (Ctx.pStimulus != NULL)
+			Ctx.pStimulus();
+		else
+			ES_CheckUserEvents();
+		HostSim_HoldClock(false);
+		Ctx.InCheckers = false;
+		// a checker that fired without posting (a timer started, a motor
+		// moved) leaves nothing to do before the next expiry either
+		if ((_HW_Process_Pending_Ints() == true) && (Ctx.Ready == 0)) {
+			// nothing can happen before the next timer expires
+			uint32_t skip;
+			if (!HostSim_NextExpiry(&skip))
+				skip = 1;
+			if (!Forever && (Until - HostSim_GetTicks() < skip))
+				skip = Until - HostSim_GetTicks();
+			HostSim_SkipTicks(skip);
+		}
+	}
+	return Success;
+}
+
+// runs the highest priority service with a waiting event until every
+// queue is empty
+static ES_Return_t runServices(void) {
+	ES_Event ThisEvent;
+
+	while ((_HW_Process_Pending_Ints() == true) && (Ctx.Ready != 0)) {
+		uint8_t HighestPrior = highestReady();
+		dequeue(HighestPrior, &ThisEvent);
+		if (ServRun[HighestPrior](ThisEvent).EventType == ES_ERROR)
+			return FailedRun;
+	}
+	return Success;
+}
+
+// takes the oldest event off a service's queue
+static bool dequeue(uint8_t WhichService, ES_Event *pEvent) {
+	HostQueue_t *pQueue = &Ctx.Queues[WhichService];
+	if (pQueue->Count == 0)
+		return false;
+
+	*pEvent = pQueue->pBuffer[pQueue->Head];
+	pQueue->Head = (pQueue->Head + 1) % pQueue->Size;
+	pQueue->Count--;
+	if (pQueue->Count == 0)
+		Ctx.Ready &= ~(1 << WhichService);
+	return true;
+}
+
+// the highest numbered service with an event waiting
+static uint8_t highestReady(void) {
+	uint8_t i = NUM_SERVICES - 1;
+	while ((i > 0) && ((Ctx.Ready & (1 << i)) == 0)) {
+		i--;
+	}
+	return i;
+}
+
+#ifdef TEST
+/* scripted playthrough: puts three hands on after one second of game time,
+   then lets the disarm timer run out, and reports how long that took */
+int main(void)
+{
+	ES_Event ThisEvent;
+	clock_t start = clock();
+
+	TERMIO_Init();
+	HostSim_SetRealTime(false);
+	printf("\n\rIn Test Harness for the host framework\r\n");
+	HostHAL_Reset();
+	HostSim_ResetClock();
+	GameContext_Init(pGame);
+	if (ES_Initialize(ES_Timer_RATE_1mS) != Success) {
+		printf("Failed Initialization\r\n");
+		return 1;
+	}
+
+	HostSim_RunUntil(1000);
+	ThisEvent.EventType = THREE_HANDS_ON;
+	ThisEvent.EventParam = 0;
+	PostDisarmFSM(ThisEvent);
+	// the disarm timer is 30000 ticks
+	HostSim_RunUntil(35000);
+
+	printf("\r\n%u ticks (%llu clocks) in %.0f ms of host time\r\n",
+			(unsigned)HostSim_GetTicks(), (unsigned long long)HostSim_GetClocks(),
+			1000.0 * (clock() - start) / CLOCKS_PER_SEC);
+	return 0;
+}
+#endif
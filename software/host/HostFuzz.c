@@ -0,0 +1,430 @@
+/****************************************************************************
+ Module
+   HostFuzz.c
+
+ Revision
+   1.0.1
+
+ Description
+   Fuzz target for DisarmFSM and KeyPadFSM. Every input is played as a
+	 sequence of events from the same starting snapshot, checking the
+	 outputs against the state after each one (see HostFuzz.h).
+
+ Notes
+   The snapshot is a copy of the whole station, restored into the same
+	 station, so the queue pointers in it stay good.
+
+	 Built with HOST_FUZZ, the TEST search runs about 24000 inputs/s over
+	 3000 inputs and 12600 inputs/s over 30000, whose inputs are longer and
+	 reach later games (it was 1100 and 620 before the LCD stopped being
+	 shifted out and the timer ticks were counted in bulk). What is left is
+	 the services themselves: a step that waits for a timer runs every tick
+	 of game time up to it, with the LCD and LED animation services working
+	 all along.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "DisarmFSM.h"
+#include "KeyPadFSM.h"
+#include "passwordGenerator.h"
+#include "LEDs.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostStation.h"
+#include "HostFuzz.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define STEP_OP(b) ((b) >> 5)
+#define STEP_ARG(b) ((b) & 0x1f)
+
+// key pad layout, as decoded by findNum in KeyPadFSM.c
+#define ZERO_KEY 10 // row 4, column 2
+#define ENTER_KEY 11 // row 4, column 3
+
+// outputs as DisarmFSM.c, Servos.c and ArmedLine.c drive them
+#define NUM_LEDS 8
+#define ALL_TOWER_LEDS 7 // six tiers and the dial; LED 6 is not fitted
+#define FLAG_SERVO 0
+#define KEY_SERVO 2
+#define FLAG_RAISED 1175
+#define FLAG_LOWERED 2250
+#define KEY_LOCK 920
+#define KEY_UNLOCK 2020
+#define ARMED_LINE_PORT GPIO_PORTF_BASE
+#define ARMED_LINE_PIN GPIO_PIN_1
+
+/*---------------------------- Module Functions ---------------------------*/
+static void setUp(void);
+static void noStimuli(void);
+static const char *doStep(uint8_t Step);
+static void postToDisarm(ES_EventTyp_t EventType);
+static void pressKey(uint8_t Key);
+static const char *checkOutputs(void);
+static void fail(const char *pWhat, const uint8_t *Data, size_t Size, size_t Step);
+
+/*---------------------------- Module Variables ---------------------------*/
+static HostStation_t Station;
+static HostStation_t Snapshot;
+static bool Ready;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     LLVMFuzzerTestOneInput
+
+ Parameters
+     const uint8_t * : the input
+		 size_t : bytes in the input
+
+ Returns
+     int : always 0, as libFuzzer expects
+
+ Description
+     puts the station back to the snapshot and plays the input one step at
+		 a time, checking the outputs after each step
+ Notes
+     aborts on the first broken rule
+****************************************************************************/
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+	if (!Ready)
+		setUp();
+
+	Station = Snapshot;
+	HostStation_Select(&Station);
+
+	for (size_t i = 0; i < Size; i++) {
+		const char *pBroken = doStep(Data[i]);
+		if (pBroken != NULL)
+			fail(pBroken, Data, Size, i);
+		if (HostSim_RunPending() != Success)
+			fail("a service returned ES_ERROR", Data, Size, i);
+		pBroken = checkOutputs();
+		if (pBroken != NULL)
+			fail(pBroken, Data, Size, i);
+	}
+	return 0;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// starts the station once and keeps it as the snapshot every input starts from
+static void setUp(void) {
+	// the firmware's printouts would swamp the fuzzer's
+	freopen("/dev/null", "w", stdout);
+
+	HostStation_Init(&Station);
+	HostStation_Select(&Station);
+	HostSim_SetStimulus(noStimuli);
+	if ((ES_Initialize(ES_Timer_RATE_1mS) != Success)
+			|| (HostSim_RunPending() != Success)) {
+		fprintf(stderr, "HostFuzz: failed to initialize\r\n");
+		abort();
+	}
+	Snapshot = Station;
+	Ready = true;
+}
+
+// stands in for the event checkers: nothing comes from outside but the input
+static void noStimuli(void) {
+}
+
+// plays one step of the input, returns the first rule it broke, NULL if none
+static const char *doStep(uint8_t Step) {
+	uint8_t arg = STEP_ARG(Step);
+	uint32_t ticks;
+
+	switch (STEP_OP(Step)) {
+		case 0:
+			postToDisarm(THREE_HANDS_ON);
+			break;
+		case 1:
+			postToDisarm(THREE_HANDS_OFF);
+			break;
+		case 2:
+			postToDisarm(KEY_INSERTED);
+			break;
+		case 3:
+			postToDisarm(CORRECT_VALUE_DIALED);
+			break;
+		case 4:
+			pressKey(arg % 12);
+			break;
+		case 5: {
+			if (arg >= 16) {
+				// the verdict alone, as the debug keys '3' and '4' post it
+				postToDisarm((arg & 1) ? CORRECT_PASSWORD_ENTERED : INCORRECT_PASSWORD_ENTERED);
+				break;
+			}
+			uint8_t num = arg % NUM_PASSWORDS + 1;
+			uint32_t password = getPassword(num);
+			for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
+				uint8_t digit = PASSWORD_DIGIT(password, i);
+				pressKey((digit == 0) ? ZERO_KEY : digit - 1);
+				HostSim_RunPending();
+			}
+#ifndef KEYPAD_NO_ENTER
+			// the passcode typed must be taken if it is the correct one (or
+			// came out the same), and turned down otherwise
+			bool correct = (password == getPassword(pGame->Passwords.correctPassword));
+			if (checkPassword(password) != correct)
+				return "checkPassword wrong about a passcode on show";
+			if (checkPasswordState(pGame->KeyPadFSM.Match) != correct)
+				return "key pad wrong about the passcode typed";
+#endif
+			pressKey(ENTER_KEY);
+			break;
+		}
+		case 6:
+			// jump to where timer arg runs out, if it is running
+			if (HostSim_TimeLeft(arg % HOST_NUM_TIMERS, &ticks))
+				HostSim_RunUntil(HostSim_GetTicks() + ticks);
+			break;
+		case 7:
+			HostSim_RunUntil(HostSim_GetTicks() + (arg + 1) * 64);
+			break;
+	}
+	return NULL;
+}
+
+static void postToDisarm(ES_EventTyp_t EventType) {
+	ES_Event ThisEvent;
+	ThisEvent.EventType = EventType;
+	ThisEvent.EventParam = 0;
+	PostDisarmFSM(ThisEvent);
+}
+
+// what the key pad debouncer posts for one key pressed and let go
+// (0 is the top left key)
+static void pressKey(uint8_t Key) {
+	PutKeyPadKey(Key, true);
+	PutKeyPadKey(Key, false);
+}
+
+// returns the first rule the outputs break, NULL if they agree with the state
+static const char *checkOutputs(void) {
+	uint8_t lit = 0;
+	for (uint8_t i = 0; i < NUM_LEDS; i++) {
+		if (getLEDs() & (1 << i))
+			lit++;
+	}
+	bool armed = (HostHAL_GetOutput(ARMED_LINE_PORT) & ARMED_LINE_PIN) != 0;
+	uint16_t flag = HostHAL_GetPulseWidth(FLAG_SERVO);
+	uint16_t key = HostHAL_GetPulseWidth(KEY_SERVO);
+
+	if (pGame->KeyPadFSM.sizeOfInput > MAX_PASS_SIZE)
+		return "key pad input longer than a password";
+	for (uint8_t bank = 0; bank < LED_REGISTERS; bank++) {
+		if (pGame->LEDs.dirty[bank] || (pGame->LEDs.sent[bank] != pGame->LEDs.lit[bank]))
+			return "tower LEDs changed but not sent";
+	}
+
+	switch (QueryDisarmFSM()) {
+		case Armed:
+			if (lit != 0)
+				return "Armed with tower LEDs lit";
+			if (!armed || (flag != FLAG_LOWERED) || (key != KEY_LOCK))
+				return "Armed without armed line, flag lowered and keys locked";
+			break;
+		case Stage1:
+			if (lit != 1)
+				return "Stage1 without just tier 1 lit";
+			if (!armed || (key != KEY_LOCK))
+				return "Stage1 disarmed or with the keys unlocked";
+			break;
+		case Stage1_Stagnated:
+			if (lit != 0)
+				return "Stage1_Stagnated with tower LEDs lit";
+			if (!armed || (key != KEY_LOCK))
+				return "Stage1_Stagnated disarmed or with the keys unlocked";
+			break;
+		case Stage2:
+			if (lit != 2)
+				return "Stage2 without just tiers 1 and 2 lit";
+			if (!armed || (key != KEY_UNLOCK))
+				return "Stage2 disarmed or with the keys locked";
+			break;
+		case Stage3:
+			// tiers 4 to 6 light one by one once the pot is dialed
+			if ((lit < 4) || (lit > ALL_TOWER_LEDS))
+				return "Stage3 without tiers 1 to 3 and the dial lit";
+			if (key != KEY_UNLOCK)
+				return "Stage3 with the keys locked";
+			break;
+		case Stage4:
+			if (lit != ALL_TOWER_LEDS)
+				return "Stage4 without the whole tower lit";
+			if (armed || (flag != FLAG_RAISED))
+				return "Stage4 still armed or with the flag down";
+			break;
+		default:
+			return "DisarmFSM in no known state";
+	}
+	return NULL;
+}
+
+// reports a broken rule with the input that broke it, and aborts
+static void fail(const char *pWhat, const uint8_t *Data, size_t Size, size_t Step) {
+	fprintf(stderr, "HostFuzz: %s after step %u of:", pWhat, (unsigned)Step);
+	for (size_t i = 0; i < Size; i++) {
+		fprintf(stderr, " %02x", Data[i]);
+	}
+	fprintf(stderr, "\r\n");
+	abort();
+}
+
+#ifdef TEST
+#include <string.h>
+#include <time.h>
+
+#define MAX_INPUT 256
+#define MAX_CORPUS 512
+#define NUM_STATES 6
+#define MAX_GAMES 3
+#define NUM_FEATURES ((MAX_GAMES + 1) * NUM_STATES * NUM_STATES)
+
+/* without libFuzzer: replays the input files given on the command line, or
+   runs a small guided search for the given number of inputs and reports the
+   rate. In place of code coverage the search keeps every input that makes a
+   DisarmFSM transition not seen before in that game of the input (first,
+   second, ...), so it works its way into the later games where state left
+   over from earlier ones shows up */
+typedef struct {
+	uint8_t Data[MAX_INPUT];
+	size_t Size;
+} Input_t;
+
+static Input_t Corpus[MAX_CORPUS];
+static uint32_t CorpusSize;
+static bool Seen[NUM_FEATURES];
+static uint32_t NumSeen;
+static uint32_t Seed = 2463534242u;
+
+static uint32_t xorshift(void) {
+	Seed ^= Seed << 13;
+	Seed ^= Seed >> 17;
+	Seed ^= Seed << 5;
+	return Seed;
+}
+
+// plays an input a step at a time like LLVMFuzzerTestOneInput, and
+// returns true if it made a transition not seen before
+static bool runGuided(const Input_t *pInput) {
+	bool found = false;
+	uint8_t games = 0;
+	DisarmState_t last;
+
+	if (!Ready)
+		setUp();
+	Station = Snapshot;
+	HostStation_Select(&Station);
+	last = QueryDisarmFSM();
+
+	for (size_t i = 0; i < pInput->Size; i++) {
+		const char *pBroken = doStep(pInput->Data[i]);
+		if (pBroken != NULL)
+			fail(pBroken, pInput->Data, pInput->Size, i);
+		if (HostSim_RunPending() != Success)
+			fail("a service returned ES_ERROR", pInput->Data, pInput->Size, i);
+		pBroken = checkOutputs();
+		if (pBroken != NULL)
+			fail(pBroken, pInput->Data, pInput->Size, i);
+
+		DisarmState_t now = QueryDisarmFSM();
+		uint32_t feature = (games * NUM_STATES + last) * NUM_STATES + now;
+		if (!Seen[feature]) {
+			Seen[feature] = true;
+			NumSeen++;
+			found = true;
+		}
+		if ((now == Armed) && (last != Armed) && (games < MAX_GAMES))
+			games++;
+		last = now;
+	}
+	return found;
+}
+
+// changes a copy of a corpus input a little
+static void mutate(Input_t *pInput) {
+	switch (xorshift() % 4) {
+		case 0: // change a step
+			if (pInput->Size > 0) {
+				pInput->Data[xorshift() % pInput->Size] = (uint8_t)xorshift();
+				break;
+			}
+			// fall through when there is nothing to change
+		case 1: // add a few steps to the end
+			for (uint32_t n = xorshift() % 8 + 1; (n > 0) && (pInput->Size < MAX_INPUT); n--) {
+				pInput->Data[pInput->Size++] = (uint8_t)xorshift();
+			}
+			break;
+		case 2: // put a step in somewhere
+			if (pInput->Size < MAX_INPUT) {
+				size_t at = xorshift() % (pInput->Size + 1);
+				memmove(&pInput->Data[at + 1], &pInput->Data[at], pInput->Size - at);
+				pInput->Data[at] = (uint8_t)xorshift();
+				pInput->Size++;
+			}
+			break;
+		case 3: // take a step out
+			if (pInput->Size > 0) {
+				size_t at = xorshift() % pInput->Size;
+				memmove(&pInput->Data[at], &pInput->Data[at + 1], pInput->Size - at - 1);
+				pInput->Size--;
+			}
+			break;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Input_t input;
+	struct timespec start, end;
+
+	fprintf(stderr, "\n\rIn Test Harness for the fuzz target\r\n");
+	if ((argc > 1) && (atoi(argv[1]) == 0)) {
+		for (int i = 1; i < argc; i++) {
+			FILE *pFile = fopen(argv[i], "rb");
+			if (pFile == NULL) {
+				fprintf(stderr, "cannot open %s\r\n", argv[i]);
+				return 1;
+			}
+			input.Size = fread(input.Data, 1, MAX_INPUT, pFile);
+			fclose(pFile);
+			LLVMFuzzerTestOneInput(input.Data, input.Size);
+		}
+		fprintf(stderr, "%d inputs passed\r\n", argc - 1);
+		return 0;
+	}
+
+	uint32_t numInputs = (argc > 1) ? (uint32_t)atoi(argv[1]) : 10000;
+	uint64_t steps = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t n = 0; n < numInputs; n++) {
+		if (CorpusSize == 0)
+			input.Size = 0;
+		else
+			input = Corpus[xorshift() % CorpusSize];
+		mutate(&input);
+		if (runGuided(&input) && (CorpusSize < MAX_CORPUS))
+			Corpus[CorpusSize++] = input;
+		steps += input.Size;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, "%u inputs (%llu steps) in %.2f s: %.0f execs/s, %u transitions in %u inputs kept\r\n",
+			(unsigned)numInputs, (unsigned long long)steps, seconds, numInputs / seconds,
+			(unsigned)NumSeen, (unsigned)CorpusSize);
+	return 0;
+}
+#endif
@@ -0,0 +1,53 @@
+/****************************************************************************
+
+  Header file for HostFuzz.c -- fuzzing the state machines on the host
+
+ ****************************************************************************/
+
+#ifndef HOST_FUZZ_H
+#define HOST_FUZZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* NOTES:
+
+	HostFuzz.c turns any string of bytes into a sequence of events for
+	DisarmFSM and KeyPadFSM, runs them on a station of its own and checks
+	after every event that the outputs agree with QueryDisarmFSM (tower LEDs
+	lit, armed line, flag and key servos). A broken rule prints what broke
+	and aborts, which is what a fuzzer looks for.
+
+	Each byte is one step: the top 3 bits pick it, the low 5 bits are its
+	argument.
+
+		0  THREE_HANDS_ON		4  key (arg % 12) pressed
+		1  THREE_HANDS_OFF		5  arg < 16: password (arg % 4) + 1 typed
+		2  KEY_INSERTED			   and entered, else CORRECT_PASSWORD_ENTERED
+		3  CORRECT_VALUE_DIALED	   (arg odd) or INCORRECT_PASSWORD_ENTERED
+								6  run until timer arg % 16 expires
+								7  run (arg + 1) * 64 ticks
+
+	The event checkers are switched off, so only these steps reach the state
+	machines; timers still run. Every input starts from the same snapshot of
+	the station taken just after ES_Initialize.
+
+	Building
+	----------------------------------------
+	With libFuzzer (coverage guided): build the host sources as described
+	in HostHAL.h, leaving out main.c, with clang and -fsanitize=fuzzer.
+	Without it: define TEST, and main below feeds random inputs, or replays
+	the input files named on the command line.
+
+	Define HOST_FUZZ as well, for the whole build. Nothing here looks at
+	the LCD, and with HOST_FUZZ the LCD service takes its queue without
+	shifting it out bit by bit through the simulated port C, which was
+	most of the time every input took.
+*/
+
+// Public Function Prototypes
+
+// runs one input from a fresh station, aborts if a rule is broken
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size);
+
+#endif /* HOST_FUZZ_H */
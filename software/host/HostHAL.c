@@ -0,0 +1,345 @@
+/****************************************************************************
+ Module
+   HostHAL.c
+
+ Description
+   This is the simulated Tiva register file for the host build. Every HWREG
+	 access in the drivers lands here, as do the driverlib and course library
+	 calls (SysCtlClockSet, PortFunctionInit, the ADC and the PWM library).
+
+ Notes
+	 GPIO data registers follow the Tiva rules: address bits 9:2 mask the
+	 access, writes only reach pins set as outputs, and reads return the
+	 output latch for outputs and the external level for inputs.
+
+	 The DWT cycle counter reads as the simulated clock.
+
+	 HWREG hands back a pointer, so a write through it cannot be seen as it
+	 happens. Instead each access is committed at the start of the next one
+	 (or when the host side looks at the pins). A single statement must
+	 therefore not touch two GPIO data registers, which the drivers never do.
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
+#include "driverlib/sysctl.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostStation.h"
+#include "HostWave.h"
+#include "HostLCD.h"
+#include "ADCSWTrigger.h"
+#include "PWMTiva.h"
+#include "EnablePA25_PB23_PD7_PF0.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define GPIO_DATA_END 0x400 // data register aperture is base to base + 0x3fc
+#define SYSTEM_CLOCK 40000000
+#define DWT_CYCCNT 0xE0001004 // the cycle counter (see helperFunctions.c)
+
+// this module's part of the running station
+#define Ctx (pStation->HAL)
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t portIndex(uint32_t Address);
+static uint32_t *findReg(uint32_t Address);
+static uint8_t pinLevels(uint8_t Port);
+static void commitPending(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const uint32_t PortBases[HOST_NUM_PORTS] = {
+	GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTC_BASE,
+	GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTF_BASE
+};
+
+// the registers, pins and channels themselves are kept in HostHALContext_t
+// (see HostStation.h)
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostHAL_Reset
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     puts every register, pin and channel back to its reset value. Inputs
+		 idle HI, which is the released state of the keypad rows and tape sensors
+ Notes
+
+****************************************************************************/
+void HostHAL_Reset(void) {
+	for (int i = 0; i < HOST_NUM_REGS; i++) {
+		Ctx.Regs[i].Used = false;
+	}
+	for (int i = 0; i < HOST_NUM_PORTS; i++) {
+		Ctx.PortLatch[i] = 0;
+		Ctx.PortInput[i] = 0xff;
+	}
+	for (int i = 0; i < HOST_NUM_PWM_CHANNELS; i++) {
+		Ctx.PulseWidths[i] = 0;
+	}
+	Ctx.PendingPort = HOST_NO_PORT;
+	Ctx.ADCValue = 0;
+}
+
+/****************************************************************************
+ Function
+     HostHAL_Reg
+
+ Parameters
+     uint32_t : the register address
+
+ Returns
+     volatile uint32_t * : the simulated register
+
+ Description
+     the target of every HWREG access. Commits the previous access, then
+		 either hands out the masked data window for a GPIO data register or
+		 the stored word for anything else
+ Notes
+
+****************************************************************************/
+volatile uint32_t *HostHAL_Reg(uint32_t Address) {
+	commitPending();
+	HostSim_Charge(HOST_CLOCKS_PER_ACCESS);
+
+	uint8_t port = portIndex(Address);
+	uint32_t offset = Address - ((port == HOST_NO_PORT) ? 0 : PortBases[port]);
+
+	if ((port != HOST_NO_PORT) && (offset < GPIO_DATA_END)) {
+		// address bits 9:2 select which pins this access can see
+		Ctx.PendingPort = port;
+		Ctx.PendingMask = (uint8_t)(offset >> 2);
+		Ctx.DataWindow = pinLevels(port) & Ctx.PendingMask;
+		return &Ctx.DataWindow;
+	}
+	if (Address == DWT_CYCCNT) {
+		Ctx.CycleCount = (uint32_t)HostSim_GetClocks();
+		return &Ctx.CycleCount;
+	}
+	return findReg(Address);
+}
+
+/****************************************************************************
+ Function
+     HostHAL_SetInput
+
+ Parameters
+     uint32_t : GPIO port base address
+		 uint8_t : pins to drive
+		 bool : level to drive them to
+
+ Returns
+     none
+
+ Description
+     sets the level the outside world puts on the given pins
+ Notes
+
+****************************************************************************/
+void HostHAL_SetInput(uint32_t PortBase, uint8_t Pins, bool Level) {
+	uint8_t port = portIndex(PortBase);
+	if (port == HOST_NO_PORT)
+		return;
+
+	commitPending();
+	if (Level)
+		Ctx.PortInput[port] |= Pins;
+	else
+		Ctx.PortInput[port] &= ~Pins;
+	HostWave_Pins(port, pinLevels(port));
+}
+
+/****************************************************************************
+ Function
+     HostHAL_GetPins
+
+ Parameters
+     uint32_t : GPIO port base address
+
+ Returns
+     uint8_t : level of all 8 pins of the port
+
+ Description
+     outputs read back their latch, inputs read back their driven level
+ Notes
+
+****************************************************************************/
+uint8_t HostHAL_GetPins(uint32_t PortBase) {
+	uint8_t port = portIndex(PortBase);
+	if (port == HOST_NO_PORT)
+		return 0;
+
+	commitPending();
+	return pinLevels(port);
+}
+
+/****************************************************************************
+ Function
+     HostHAL_GetOutput
+
+ Parameters
+     uint32_t : GPIO port base address
+
+ Returns
+     uint8_t : output latch of the port, masked to its output pins
+
+ Description
+     returns what the firmware is driving out of the port
+ Notes
+
+****************************************************************************/
+uint8_t HostHAL_GetOutput(uint32_t PortBase) {
+	uint8_t port = portIndex(PortBase);
+	if (port == HOST_NO_PORT)
+		return 0;
+
+	commitPending();
+	return Ctx.PortLatch[port] & (uint8_t)*findReg(PortBase + GPIO_O_DIR);
+}
+
+/****************************************************************************
+ Function
+     HostHAL_SetADC
+
+ Parameters
+     uint16_t : 12 bit conversion result
+
+ Returns
+     none
+
+ Description
+     sets what ADC0_InSeq3 returns from now on
+ Notes
+
+****************************************************************************/
+void HostHAL_SetADC(uint16_t Value) {
+	Ctx.ADCValue = Value & 0x0fff;
+}
+
+/****************************************************************************
+ Function
+     HostHAL_GetPulseWidth
+
+ Parameters
+     uint8_t : PWM channel
+
+ Returns
+     uint16_t : pulse width last set on the channel
+
+ Description
+     reads back a servo position
+ Notes
+
+****************************************************************************/
+uint16_t HostHAL_GetPulseWidth(uint8_t Channel) {
+	if (Channel >= HOST_NUM_PWM_CHANNELS)
+		return 0;
+	return Ctx.PulseWidths[Channel];
+}
+
+/*------------------------ Library Replacements ---------------------------*/
+/* driverlib */
+void SysCtlClockSet(uint32_t ui32Config) {
+	// the host clock is fixed
+}
+
+uint32_t SysCtlClockGet(void) {
+	return SYSTEM_CLOCK;
+}
+
+/* EnablePA25_PB23_PD7_PF0 */
+void PortFunctionInit(void) {
+	// nothing is locked or muxed away from GPIO on the host
+}
+
+/* ADCSWTrigger */
+void ADC0_InitSWTriggerSeq3(uint32_t channelNum) {
+	// only the pot is sampled, so the channel is not tracked
+}
+
+uint32_t ADC0_InSeq3(void) {
+	return Ctx.ADCValue;
+}
+
+/* PWMTiva */
+void PWM_TIVA_Init(void) {
+	for (int i = 0; i < HOST_NUM_PWM_CHANNELS; i++) {
+		Ctx.PulseWidths[i] = 0;
+	}
+}
+
+void PWM_TIVA_SetFreq(uint16_t reqFreq, uint8_t group) {
+	// servo frequency does not affect anything that is simulated
+}
+
+void PWM_TIVA_SetPulseWidth(uint16_t NewPW, uint8_t channel) {
+	if (channel < HOST_NUM_PWM_CHANNELS)
+		Ctx.PulseWidths[channel] = NewPW;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// returns which GPIO port an address falls in, or NO_PORT
+static uint8_t portIndex(uint32_t Address) {
+	for (uint8_t i = 0; i < HOST_NUM_PORTS; i++) {
+		if ((Address >= PortBases[i]) && (Address < PortBases[i] + 0x1000))
+			return i;
+	}
+	return HOST_NO_PORT;
+}
+
+// finds (or makes) the stored word for a register address
+static uint32_t *findReg(uint32_t Address) {
+	uint32_t slot = ((Address >> 2) * 2654435761u) & (HOST_NUM_REGS - 1);
+
+	for (int i = 0; i < HOST_NUM_REGS; i++) {
+		HostReg_t *reg = &Ctx.Regs[(slot + i) & (HOST_NUM_REGS - 1)];
+		if (!reg->Used) {
+			reg->Used = true;
+			reg->Address = Address;
+			reg->Value = 0;
+			return &reg->Value;
+		}
+		if (reg->Address == Address)
+			return &reg->Value;
+	}
+	printf("HostHAL: register file full at 0x%08x\r\n", (unsigned)Address);
+	exit(EXIT_FAILURE);
+}
+
+// what the data register of a port reads back before masking
+static uint8_t pinLevels(uint8_t Port) {
+	uint8_t dir = (uint8_t)*findReg(PortBases[Port] + GPIO_O_DIR);
+	return (Ctx.PortLatch[Port] & dir) | (Ctx.PortInput[Port] & ~dir);
+}
+
+// applies whatever was written through the last data window
+static void commitPending(void) {
+	if (Ctx.PendingPort == HOST_NO_PORT)
+		return;
+
+	uint8_t port = Ctx.PendingPort;
+	Ctx.PendingPort = HOST_NO_PORT;
+
+	// only unmasked output pins take the written value
+	uint8_t dir = (uint8_t)*findReg(PortBases[port] + GPIO_O_DIR);
+	uint8_t bits = Ctx.PendingMask & dir;
+	Ctx.PortLatch[port] = (Ctx.PortLatch[port] & ~bits) | ((uint8_t)Ctx.DataWindow & bits);
+
+	uint8_t levels = (Ctx.PortLatch[port] & dir) | (Ctx.PortInput[port] & ~dir);
+	HostWave_Pins(port, levels);
+	HostLCD_Pins(port, levels);
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+
+  Header file for HostHAL.c -- the simulated Tiva register file
+
+ ****************************************************************************/
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* NOTES:
+
+	The host build runs main.c, the state machines and every driver on a
+	Linux machine. HWREG and the driverlib / course library calls resolve to
+	the simulated register file in HostHAL.c, and the framework runs on the
+	host versions of ES_Framework.c, ES_Port.c and ES_Timers.c in this
+	directory (see HostSim.h for how time passes).
+
+	Building for the host
+	----------------------------------------
+	Compile every .c file in this directory and in software/, plus the
+	framework's ES_CheckEvents.c, with HOST_SIM defined and host/ first on
+	the include path:
+
+		cc -std=gnu99 -pthread -DHOST_SIM -Ihost -I. -I<framework> -I<TivaWare> ...
+
+	host/inc/hw_types.h, host/ES_Port.h and host/termio.h are then found
+	before the Tiva copies. Leave out the framework's ES_Framework.c,
+	ES_Port.c, ES_Timers.c and termio.c and the TivaWare driverlib sources -
+	this directory provides all of those.
+
+	Driving the inputs
+	----------------------------------------
+	Input pins (tape sensor PD7, slot detector PB2, keypad rows PD0-3) read
+	whatever was last given to HostHAL_SetInput, and the pot reads the value
+	given to HostHAL_SetADC. Outputs are read back with HostHAL_GetOutput
+	and HostHAL_GetPulseWidth.
+*/
+
+// number of PWM channels kept by the PWM_TIVA_ calls
+#define HOST_NUM_PWM_CHANNELS 8
+
+// Public Function Prototypes
+
+// clears every simulated register, pin and channel back to reset values
+void HostHAL_Reset(void);
+
+// drives the external level of the given pins of a GPIO port (by base address)
+void HostHAL_SetInput(uint32_t PortBase, uint8_t Pins, bool Level);
+
+// returns the level of a GPIO port's pins as the outside world sees them
+uint8_t HostHAL_GetPins(uint32_t PortBase);
+
+// returns the output latch of a GPIO port, masked to the pins set as outputs
+uint8_t HostHAL_GetOutput(uint32_t PortBase);
+
+// sets the value returned by the next ADC conversions (0 to 4095)
+void HostHAL_SetADC(uint16_t Value);
+
+// returns the pulse width last set on a PWM channel
+uint16_t HostHAL_GetPulseWidth(uint8_t Channel);
+
+#endif /* HOST_HAL_H */
@@ -0,0 +1,571 @@
+/****************************************************************************
+ Module
+   HostLCD.c
+
+ Revision
+   1.0.1
+
+ Description
+   A 74HC595 feeding an HD44780, driven by the LCD pins of the host build.
+	 It decodes what LCD.c sends, keeps the display contents, and checks the
+	 timing of every edge against the data sheets (see HostLCD.h).
+
+ Notes
+   The shift register byte is kept in the same bit order LCD.c builds it
+	 in, which is the order the bits come out of the 595 on the board.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "HostSim.h"
+#include "HostStation.h"
+#include "HostLCD.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// the pins as LCD.c uses them, port C
+#define LCD_PORT 2
+#define LCD_DATA (1 << 4)
+#define LCD_SCK (1 << 5)
+#define LCD_RCK (1 << 6)
+
+// the 595 outputs, in the bit order of LCD.c
+#define D4 0x80
+#define D5 0x40
+#define D6 0x20
+#define D7 0x10
+#define DATA_LINES (D4 | D5 | D6 | D7)
+#define RS 0x08
+#define RW 0x04
+#define E 0x02
+
+// data sheet timing, in clocks of the simulated 40MHz clock
+#define NS_PER_CLOCK 25
+#define NS(x) (((x) + NS_PER_CLOCK - 1) / NS_PER_CLOCK)
+#define US(x) NS((x) * 1000ULL)
+#define SER_SETUP NS(20)
+#define SCK_HIGH NS(20)
+#define SCK_TO_RCK NS(20)
+#define RCK_HIGH NS(20)
+#define RS_SETUP NS(40)
+#define E_HIGH NS(230)
+#define E_CYCLE NS(500)
+#define DATA_SETUP NS(80)
+#define DATA_HOLD NS(10)
+#define POWER_ON_TIME US(15000)
+#define FIRST_INIT_TIME US(4100)
+#define SECOND_INIT_TIME US(100)
+#define CLEAR_TIME US(1520)
+#define INSTRUCTION_TIME US(37)
+#define WRITE_TIME US(41)
+
+// the instructions, by their highest set bit
+#define CLEAR 0x01
+#define HOME 0x02
+#define ENTRY_MODE 0x04
+#define DISPLAY_CONTROL 0x08
+#define SHIFT 0x10
+#define FUNCTION_SET 0x20
+#define SET_CGRAM 0x40
+#define SET_DDRAM 0x80
+
+// DDRAM layout: one line of 80, or two of 40 at 0x00 and 0x40
+#define ONE_LINE_SIZE 80
+#define LINE_SIZE 40
+#define SECOND_LINE 0x40
+#define CGRAM_SIZE 64
+#define BLANK ' '
+
+// this module's part of the running station
+#define Ctx (pStation->LCD)
+
+/*---------------------------- Module Functions ---------------------------*/
+static void powerOn(uint64_t Now);
+static void latchOutputs(uint64_t Now);
+static void writeNibble(uint64_t Now, uint8_t Lines);
+static void execute(uint64_t Now, bool Data, uint8_t Value);
+static uint8_t nextAddress(uint8_t Address, bool Up);
+static void shiftDisplay(bool Left);
+static void violation(uint64_t Now, const char *pRule, uint64_t Clocks, uint64_t Limit);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the 595 and the display of each station are kept in HostLCDContext_t
+// (see HostStation.h)
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostLCD_Pins
+
+ Parameters
+     uint8_t : port index (0 is port A)
+		 uint8_t : pin levels now
+
+ Returns
+     none
+
+ Description
+     clocks the 595 on SCK and RCK rising, checking the 595 timing, and
+		 hands changed outputs on to the display
+ Notes
+     called on every GPIO data write, so it returns at once for other ports
+****************************************************************************/
+void HostLCD_Pins(uint8_t Port, uint8_t Levels) {
+	if (Port != LCD_PORT)
+		return;
+
+	uint64_t now = HostSim_GetClocks();
+	uint8_t rose = Levels & ~Ctx.Pins;
+	uint8_t fell = Ctx.Pins & ~Levels;
+
+	if (!Ctx.Powered)
+		powerOn(0);
+
+	if ((rose | fell) & LCD_DATA)
+		Ctx.DataChangedAt = now;
+
+	if (rose & LCD_SCK) {
+		if (now - Ctx.DataChangedAt < SER_SETUP)
+			violation(now, "595 data set up before SCK", now - Ctx.DataChangedAt, SER_SETUP);
+		Ctx.Shift = (uint8_t)((Ctx.Shift << 1) | ((Levels & LCD_DATA) ? 1 : 0));
+		Ctx.SckRoseAt = now;
+	}
+	if ((fell & LCD_SCK) && (now - Ctx.SckRoseAt < SCK_HIGH))
+		violation(now, "595 SCK high", now - Ctx.SckRoseAt, SCK_HIGH);
+
+	if (rose & LCD_RCK) {
+		if (now - Ctx.SckRoseAt < SCK_TO_RCK)
+			violation(now, "595 SCK before RCK", now - Ctx.SckRoseAt, SCK_TO_RCK);
+		Ctx.RckRoseAt = now;
+		latchOutputs(now);
+	}
+	if ((fell & LCD_RCK) && (now - Ctx.RckRoseAt < RCK_HIGH))
+		violation(now, "595 RCK high", now - Ctx.RckRoseAt, RCK_HIGH);
+
+	Ctx.Pins = Levels;
+}
+
+/****************************************************************************
+ Function
+     HostLCD_GetLine
+
+ Parameters
+     uint8_t : line, 0 is the top one
+		 char * : room for HOST_LCD_COLUMNS characters and a terminator
+
+ Returns
+     none
+
+ Description
+     reads back what a line shows, display shift included
+ Notes
+     CGRAM characters come back as their codes, 0 to 7
+****************************************************************************/
+void HostLCD_GetLine(uint8_t Line, char *pDest) {
+	for (uint8_t column = 0; column < HOST_LCD_COLUMNS; column++) {
+		uint8_t address;
+		if (!Ctx.Powered || !Ctx.DisplayOn || (Line >= HOST_LCD_LINES)
+				|| (!Ctx.TwoLines && (Line > 0))) {
+			pDest[column] = BLANK;
+			continue;
+		}
+		if (Ctx.TwoLines)
+			address = Line * SECOND_LINE + (column + Ctx.DisplayShift) % LINE_SIZE;
+		else
+			address = (column + Ctx.DisplayShift) % ONE_LINE_SIZE;
+		pDest[column] = (char)Ctx.DDRAM[address];
+	}
+	pDest[HOST_LCD_COLUMNS] = '\0';
+}
+
+/****************************************************************************
+ Function
+     HostLCD_GetGlyph
+
+ Parameters
+     uint8_t : CGRAM character, 0 to 7
+		 uint8_t * : room for its 8 rows
+
+ Returns
+     none
+
+ Description
+     reads back the dots of a character the firmware made
+ Notes
+     only the low 5 bits of a row are dots
+****************************************************************************/
+void HostLCD_GetGlyph(uint8_t Code, uint8_t *pRows) {
+	for (uint8_t row = 0; row < 8; row++) {
+		pRows[row] = Ctx.CGRAM[((Code % 8) * 8 + row) % CGRAM_SIZE] & 0x1F;
+	}
+}
+
+/****************************************************************************
+ Function
+     HostLCD_GetViolations
+
+ Parameters
+     const char ** : set to the first rule broken, or "" (may be NULL)
+
+ Returns
+     uint32_t : rules broken since power on
+
+ Description
+     reports the timing checks that failed
+ Notes
+
+****************************************************************************/
+uint32_t HostLCD_GetViolations(const char **ppFirst) {
+	if (ppFirst != NULL)
+		*ppFirst = Ctx.FirstViolation;
+	return Ctx.Violations;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// the display's own reset at power on: 8 bit mode, one line, display off,
+// DDRAM blank, busy for POWER_ON_TIME from Now
+static void powerOn(uint64_t Now) {
+	Ctx.Powered = true;
+	Ctx.FourBit = false;
+	Ctx.HaveHigh = false;
+	Ctx.InitWrites = 0;
+	Ctx.BusyUntil = Now + POWER_ON_TIME;
+	Ctx.Address = 0;
+	Ctx.CGMode = false;
+	Ctx.Increment = true;
+	Ctx.ShiftDisplay = false;
+	Ctx.DisplayOn = false;
+	Ctx.TwoLines = false;
+	Ctx.DisplayShift = 0;
+	memset(Ctx.DDRAM, BLANK, sizeof(Ctx.DDRAM));
+}
+
+// the 595 storage register takes the shift register; E edges reach the
+// display, checked against the lines that moved with or before them
+static void latchOutputs(uint64_t Now) {
+	uint8_t before = Ctx.Outputs;
+	uint8_t after = Ctx.Shift;
+	uint8_t changed = before ^ after;
+
+	if ((after & E) && !(before & E)) {
+		if (Now - Ctx.RSChangedAt < RS_SETUP)
+			violation(Now, "RS set up before E", Now - Ctx.RSChangedAt, RS_SETUP);
+		if (Now - Ctx.ERoseAt < E_CYCLE)
+			violation(Now, "E cycle", Now - Ctx.ERoseAt, E_CYCLE);
+		Ctx.ERoseAt = Now;
+	}
+	if ((before & E) && !(after & E)) {
+		if (Now - Ctx.ERoseAt < E_HIGH)
+			violation(Now, "E high", Now - Ctx.ERoseAt, E_HIGH);
+		if (Now - Ctx.LinesChangedAt < DATA_SETUP)
+			violation(Now, "data set up before E falls", Now - Ctx.LinesChangedAt, DATA_SETUP);
+		if (changed & (DATA_LINES | RS | RW))
+			violation(Now, "data held after E falls", 0, DATA_HOLD);
+		if (before & RW)
+			violation(Now, "RW high during a write", 0, 0);
+		writeNibble(Now, before);
+	}
+
+	if (changed & (RS | RW))
+		Ctx.RSChangedAt = Now;
+	if (changed & (DATA_LINES | RS | RW))
+		Ctx.LinesChangedAt = Now;
+	Ctx.Outputs = after;
+}
+
+// one write to the display; in 4 bit mode two of them make a byte
+static void writeNibble(uint64_t Now, uint8_t Lines) {
+	uint8_t nibble = ((Lines & D7) ? 8 : 0) | ((Lines & D6) ? 4 : 0)
+			| ((Lines & D5) ? 2 : 0) | ((Lines & D4) ? 1 : 0);
+	bool data = ((Lines & RS) != 0);
+
+	if (Now < Ctx.BusyUntil)
+		violation(Now, "write after the last instruction", Now
+				- (Ctx.BusyUntil - Ctx.BusyTime), Ctx.BusyTime);
+
+	if (!Ctx.FourBit) {
+		// DB3-0 are not wired, so they read 0
+		execute(Now, data, (uint8_t)(nibble << 4));
+	} else if (!Ctx.HaveHigh) {
+		Ctx.High = nibble;
+		Ctx.HaveHigh = true;
+	} else {
+		Ctx.HaveHigh = false;
+		execute(Now, data, (uint8_t)((Ctx.High << 4) | nibble));
+	}
+}
+
+// carries out one instruction or data write and starts its execution time
+static void execute(uint64_t Now, bool Data, uint8_t Value) {
+	uint64_t time = INSTRUCTION_TIME;
+
+	if (Data) {
+		if (Ctx.CGMode) {
+			Ctx.CGRAM[Ctx.Address % CGRAM_SIZE] = Value;
+			Ctx.Address = (Ctx.Address + (Ctx.Increment ? 1 : CGRAM_SIZE - 1)) % CGRAM_SIZE;
+		} else {
+			Ctx.DDRAM[Ctx.Address] = Value;
+			Ctx.Address = nextAddress(Ctx.Address, Ctx.Increment);
+			if (Ctx.ShiftDisplay)
+				shiftDisplay(Ctx.Increment);
+		}
+		time = WRITE_TIME;
+	} else if (Value & SET_DDRAM) {
+		Ctx.Address = Value & ~SET_DDRAM;
+		Ctx.CGMode = false;
+	} else if (Value & SET_CGRAM) {
+		Ctx.Address = Value & (CGRAM_SIZE - 1);
+		Ctx.CGMode = true;
+	} else if (Value & FUNCTION_SET) {
+		if (!Ctx.FourBit) {
+			// the reset by instruction: slow first and second function sets
+			if (Ctx.InitWrites == 0)
+				time = FIRST_INIT_TIME;
+			else if (Ctx.InitWrites == 1)
+				time = SECOND_INIT_TIME;
+			Ctx.InitWrites++;
+		}
+		Ctx.FourBit = ((Value & 0x10) == 0);
+		Ctx.TwoLines = ((Value & 0x08) != 0);
+	} else if (Value & SHIFT) {
+		bool right = ((Value & 0x04) != 0);
+		if (Value & 0x08)
+			shiftDisplay(!right);
+		else
+			Ctx.Address = nextAddress(Ctx.Address, right);
+	} else if (Value & DISPLAY_CONTROL) {
+		Ctx.DisplayOn = ((Value & 0x04) != 0);
+		Ctx.CursorOn = ((Value & 0x02) != 0);
+		Ctx.Blink = ((Value & 0x01) != 0);
+	} else if (Value & ENTRY_MODE) {
+		Ctx.Increment = ((Value & 0x02) != 0);
+		Ctx.ShiftDisplay = ((Value & 0x01) != 0);
+	} else if (Value & HOME) {
+		Ctx.Address = 0;
+		Ctx.CGMode = false;
+		Ctx.DisplayShift = 0;
+		time = CLEAR_TIME;
+	} else if (Value & CLEAR) {
+		memset(Ctx.DDRAM, BLANK, sizeof(Ctx.DDRAM));
+		Ctx.Address = 0;
+		Ctx.CGMode = false;
+		Ctx.DisplayShift = 0;
+		Ctx.Increment = true;
+		time = CLEAR_TIME;
+	}
+
+	Ctx.BusyTime = time;
+	Ctx.BusyUntil = Now + time;
+}
+
+// the DDRAM address after Address, wrapping the way the display does
+static uint8_t nextAddress(uint8_t Address, bool Up) {
+	if (!Ctx.TwoLines)
+		return (uint8_t)((Address + (Up ? 1 : ONE_LINE_SIZE - 1)) % ONE_LINE_SIZE);
+
+	if (Up) {
+		if (Address == LINE_SIZE - 1)
+			return SECOND_LINE;
+		if (Address == SECOND_LINE + LINE_SIZE - 1)
+			return 0;
+		return Address + 1;
+	}
+	if (Address == 0)
+		return SECOND_LINE + LINE_SIZE - 1;
+	if (Address == SECOND_LINE)
+		return LINE_SIZE - 1;
+	return Address - 1;
+}
+
+// moves what is shown one place along the DDRAM lines
+static void shiftDisplay(bool Left) {
+	uint8_t size = Ctx.TwoLines ? LINE_SIZE : ONE_LINE_SIZE;
+	Ctx.DisplayShift = (uint8_t)((Ctx.DisplayShift + (Left ? 1 : size - 1)) % size);
+}
+
+// counts a broken rule, keeping the first as text
+static void violation(uint64_t Now, const char *pRule, uint64_t Clocks, uint64_t Limit) {
+	if (Ctx.Violations++ == 0)
+		snprintf(Ctx.FirstViolation, sizeof(Ctx.FirstViolation),
+				"%s at %llu ns: %llu ns, needs %llu ns", pRule,
+				(unsigned long long)(Now * NS_PER_CLOCK),
+				(unsigned long long)(Clocks * NS_PER_CLOCK),
+				(unsigned long long)(Limit * NS_PER_CLOCK));
+}
+
+/****************************************************************************
+ Test Harness for the LCD model
+
+ Description
+     starts the game with the event checkers off, then puts each message of
+		 LCD.c on the display through the LCD service and checks what the top
+		 line shows, and that no timing rule was broken
+ Notes
+****************************************************************************/
+#ifdef TEST
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "LCD.h"
+#include "passwordGenerator.h"
+
+typedef struct {
+	void (*pPrint)(void);
+	const char *pExpected;
+} Message_t;
+
+static const Message_t Messages[] = {
+	{printAuthorizedMessage, "Authorized!     "},
+	{printTimeUp, "Your Time Is Up!"},
+	{printIncorrectMessage, "Incorrect Passwo"},
+	{printArmedMessage, "Armed           "},
+	// the same again sends nothing
+	{printArmedMessage, "Armed           "},
+};
+
+// nothing happens but what the harness does
+static void noStimuli(void) {
+}
+
+// runs the framework tick by tick until the LCD service has sent everything
+static uint32_t showLCD(void) {
+	uint32_t start = HostSim_GetTicks();
+
+	while (isLCDBusy()) {
+		HostSim_RunUntil(HostSim_GetTicks() + 1);
+	}
+	return HostSim_GetTicks() - start;
+}
+
+static bool checkLine(uint8_t Line, const char *pExpected) {
+	char line[HOST_LCD_COLUMNS + 1];
+
+	HostLCD_GetLine(Line, line);
+	bool same = (strcmp(line, pExpected) == 0);
+	printf("[%s] %s", line, same ? "ok" : "WRONG");
+	return same;
+}
+
+int main(void) {
+	const char *pFirst;
+	int failures = 0;
+
+	puts("\n\r In Test Harness for the LCD model\r");
+
+	HostSim_SetStimulus(noStimuli);
+	ES_Initialize(ES_Timer_RATE_1mS);
+	// the Armed message from DisarmFSM's ES_INIT
+	HostSim_RunPending();
+	showLCD();
+	if (!checkLine(0, "Armed           "))
+		failures++;
+	printf("\n");
+
+	for (uint8_t i = 0; i < sizeof(Messages) / sizeof(Messages[0]); i++) {
+		Messages[i].pPrint();
+		uint32_t ticks = showLCD();
+
+		if (!checkLine(0, Messages[i].pExpected))
+			failures++;
+		printf("  shown after %u ticks\n", (unsigned)ticks);
+	}
+
+	// the second line goes to its own DDRAM address, the first stays
+	LCDwriteLine(1, "Line two");
+	uint32_t ticks = showLCD();
+	if (!checkLine(0, "Armed           "))
+		failures++;
+	printf("\n");
+	if (!checkLine(1, "Line two        "))
+		failures++;
+	printf("  shown after %u ticks\n", (unsigned)ticks);
+
+	// text and digits carry on from where the line ends
+	const uint8_t digits[] = {4, 0, 9};
+	LCDwriteLine(1, "Code");
+	LCDputs(": ");
+	LCDputDigits(digits, sizeof(digits));
+	ticks = showLCD();
+	if (!checkLine(1, "Code: 409       "))
+		failures++;
+	printf("  shown after %u ticks\n", (unsigned)ticks);
+
+	// the passcode carousel, with the passcodes from DisarmFSM's ES_INIT
+	resetLCDmessage();
+	for (uint8_t page = 0; page < LCD_PAGES; page++) {
+		char text[HOST_LCD_COLUMNS + 1] = "Welcome DrEd";
+		char expected[HOST_LCD_COLUMNS + 1];
+
+		if (page == 1)
+			strcpy(text, "Passcodes:");
+		if (page > 1) {
+			for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
+				text[i] = '0' + PASSWORD_DIGIT(getPassword(page - 1), i);
+			}
+			text[MAX_PASS_LENGTH] = '\0';
+		}
+		snprintf(expected, sizeof(expected), "%-16s", text);
+
+		printLCDmessage();
+		ticks = showLCD();
+		if (!checkLine(0, expected))
+			failures++;
+		printf("  shown after %u ticks\n", (unsigned)ticks);
+	}
+
+	// the countdown bar: the glyphs went to CGRAM with the first message
+	for (uint8_t code = 1; code < 5; code++) {
+		uint8_t rows[8];
+		uint8_t expected = (uint8_t)((0x1F << (5 - code)) & 0x1F);
+		bool same = true;
+
+		HostLCD_GetGlyph(code, rows);
+		for (uint8_t row = 0; row < 8; row++) {
+			same = same && (rows[row] == expected);
+		}
+		printf("glyph %u: %02x %s\n", (unsigned)code, rows[0], same ? "ok" : "WRONG");
+		if (!same)
+			failures++;
+	}
+
+	// 8000 ticks over 80 dots, one dot every 100 ticks
+	char full[HOST_LCD_COLUMNS + 1];
+	memset(full, 0xFF, HOST_LCD_COLUMNS);
+	full[HOST_LCD_COLUMNS] = '\0';
+	uint32_t start = HostSim_GetTicks();
+	LCDstartCountdown(8000);
+	ticks = showLCD();
+	if (!checkLine(1, full))
+		failures++;
+	printf("  shown after %u ticks\n", (unsigned)ticks);
+
+	// 43 dots left after 3700 ticks: 8 full cells, a 3 dot glyph, blanks
+	HostSim_RunUntil(start + 3700);
+	HostSim_RunPending();
+	ticks = showLCD();
+	char expected[HOST_LCD_COLUMNS + 1];
+	memset(expected, ' ', HOST_LCD_COLUMNS);
+	memset(expected, 0xFF, 8);
+	expected[8] = 3;
+	expected[HOST_LCD_COLUMNS] = '\0';
+	if (!checkLine(1, expected))
+		failures++;
+	printf("  one dot shown after %u ticks\n", (unsigned)ticks);
+
+	// stopping blanks the line, the first stays
+	LCDstopCountdown();
+	showLCD();
+	if (!checkLine(1, "                "))
+		failures++;
+	printf("\n");
+
+	uint32_t violations = HostLCD_GetViolations(&pFirst);
+	printf("%u timing violations%s%s\n", (unsigned)violations,
+			violations ? ", first: " : "", pFirst);
+	return (failures + violations) ? 1 : 0;
+}
+#endif
@@ -0,0 +1,60 @@
+/****************************************************************************
+
+  Header file for HostLCD.c -- the LCD and its shift register, simulated
+
+ ****************************************************************************/
+
+#ifndef HOST_LCD_H
+#define HOST_LCD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* NOTES:
+
+	HostLCD.c watches the three LCD pins (PC4 data, PC5 SCK, PC6 RCK) and
+	plays them into a 74HC595, whose outputs drive an HD44780 the way
+	LCD.c wires it: D4-D5-D6-D7-RS-RW-E from the first bit shifted in. The
+	display decodes the instructions like the real one (8 bit mode after
+	power on, function set into 4 bit mode, clear, entry mode, display
+	control, shifts, CGRAM and DDRAM addresses) and keeps its DDRAM and
+	CGRAM, so a test can read back what the display shows.
+
+	It also holds every edge to the data sheet timing, using the simulated
+	clock (25 ns a step):
+
+		74HC595	data setup to SCK 20 ns, SCK and RCK high 20 ns,
+				SCK to RCK 20 ns
+		HD44780	RS setup to E 40 ns, E high 230 ns, E cycle 500 ns,
+				data setup to E falling 80 ns, hold 10 ns, and no
+				write while the last instruction is still executing
+				(15 ms after power on, 4.1 ms and 100 us after the
+				first two function sets, 1.52 ms for clear and home,
+				37 us for the rest)
+
+	Every broken rule is counted; the first one is kept as text. A write
+	that breaks the hold time still latches the data from before the edge,
+	so the contents show what a display would most likely do.
+*/
+
+// the display as fitted, two lines of 16
+#define HOST_LCD_COLUMNS 16
+#define HOST_LCD_LINES 2
+
+// Public Function Prototypes
+
+// called by HostHAL.c with a port's pin levels whenever they may have changed
+void HostLCD_Pins(uint8_t Port, uint8_t Levels);
+
+// copies the HOST_LCD_COLUMNS characters shown on a line into pDest, and
+// a terminator; blank if the display is off
+void HostLCD_GetLine(uint8_t Line, char *pDest);
+
+// copies the 8 rows of CGRAM character Code (0 to 7) into pRows, the
+// leftmost dot in bit 4
+void HostLCD_GetGlyph(uint8_t Code, uint8_t *pRows);
+
+// returns the timing rules broken so far, and the first one as text
+uint32_t HostLCD_GetViolations(const char **ppFirst);
+
+#endif /* HOST_LCD_H */
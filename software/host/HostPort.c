@@ -0,0 +1,385 @@
+/****************************************************************************
+ Module
+   HostPort.c
+
+ Revision
+   1.0.1
+
+ Description
+   Host replacement for the Tiva ES_Port.c and termio.c. The framework tick
+	 comes from a simulated 40MHz clock instead of SysTick, and the console
+	 reads keystrokes from stdin.
+
+ Notes
+   The clock only moves when work is charged to it (see HostSim.h) or when
+	 the host loop skips ahead to the next timer expiry. With real time pacing
+	 on, it is also pulled along by the host's monotonic clock.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+
+#include "ES_Port.h"
+#include "ES_Timers.h"
+#include "termio.h"
+#include "HostSim.h"
+#include "HostStation.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// one clock of the 40MHz Tiva system clock, in ns
+#define NS_PER_CLOCK 25
+#define NO_KEY (-1)
+// longest single sleep while pacing, so keystrokes are still seen
+#define MAX_SLEEP_NS 10000000
+
+// this module's part of the running station
+#define Ctx (pStation->Clock)
+
+/*---------------------------- Module Functions ---------------------------*/
+static void catchUp(void);
+static uint64_t nowNs(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the clock of each station is kept in HostClockContext_t (see HostStation.h)
+
+// there is one console however many stations there are, and only a program
+// that called TERMIO_Init reads it
+static bool ConsoleOpen = false;
+static int PendingKey = NO_KEY;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     _HW_Timer_Init
+
+ Parameters
+     TimerRate_t : the tick rate, in 40MHz clocks
+
+ Returns
+     none
+
+ Description
+     sets the tick period; the next tick is one period from now
+ Notes
+     called again by drivers that change the rate, just like on the Tiva
+****************************************************************************/
+void _HW_Timer_Init(const TimerRate_t Rate) {
+	catchUp();
+	Ctx.ClocksPerTick = (uint64_t)Rate;
+	Ctx.NextTickClocks = Ctx.Clocks + Ctx.ClocksPerTick;
+}
+
+/****************************************************************************
+ Function
+     _HW_Process_Pending_Ints
+
+ Parameters
+     none
+
+ Returns
+     bool, always true
+
+ Description
+     hands every tick that has elapsed since the last call to the timer
+		 module, standing in for the SysTick interrupt
+ Notes
+
+****************************************************************************/
+bool _HW_Process_Pending_Ints(void) {
+	catchUp();
+	if (Ctx.TickCount > 0) {
+		uint32_t ticks = Ctx.TickCount;
+		Ctx.TickCount = 0;
+		HostSim_CountTicks(ticks);
+	}
+	return true;
+}
+
+/****************************************************************************
+ Function
+     _HW_GetTickCount
+
+ Parameters
+     none
+
+ Returns
+     uint16_t : ticks since the timer was started
+
+ Description
+     returns the free running tick counter
+ Notes
+
+****************************************************************************/
+uint16_t _HW_GetTickCount(void) {
+	// busy waits poll this, so reading it has to take time
+	HostSim_Charge(HOST_CLOCKS_PER_TICK_READ);
+	catchUp();
+	return (uint16_t)Ctx.SysTickCounter;
+}
+
+/****************************************************************************
+ Function
+     HostSim_ResetClock
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     puts the clock and tick counters back to zero with the tick off
+ Notes
+
+****************************************************************************/
+void HostSim_ResetClock(void) {
+	Ctx.Clocks = 0;
+	Ctx.ClocksPerTick = 0;
+	Ctx.TickCount = 0;
+	Ctx.SysTickCounter = 0;
+	Ctx.WallStartNs = nowNs();
+}
+
+/****************************************************************************
+ Function
+     HostSim_Charge
+
+ Parameters
+     uint32_t : number of clocks
+
+ Returns
+     none
+
+ Description
+     advances the simulated clock by the time some work takes
+ Notes
+
+****************************************************************************/
+void HostSim_Charge(uint32_t NumClocks) {
+	if (!Ctx.Held)
+		Ctx.Clocks += NumClocks;
+}
+
+/****************************************************************************
+ Function
+     HostSim_GetClocks
+
+ Parameters
+     none
+
+ Returns
+     uint64_t : clocks since reset
+
+ Description
+     returns the simulated clock
+ Notes
+
+****************************************************************************/
+uint64_t HostSim_GetClocks(void) {
+	return Ctx.Clocks;
+}
+
+/****************************************************************************
+ Function
+     HostSim_GetTicks
+
+ Parameters
+     none
+
+ Returns
+     uint32_t : ticks since reset
+
+ Description
+     returns the full width tick counter, without charging for the read
+ Notes
+
+****************************************************************************/
+uint32_t HostSim_GetTicks(void) {
+	catchUp();
+	return Ctx.SysTickCounter;
+}
+
+/****************************************************************************
+ Function
+     HostSim_SkipTicks
+
+ Parameters
+     uint32_t : number of ticks
+
+ Returns
+     none
+
+ Description
+     moves the clock to the Nth tick from now. With real time pacing on it
+		 sleeps towards that tick instead, a little at a time
+ Notes
+     does nothing while the tick is off
+****************************************************************************/
+void HostSim_SkipTicks(uint32_t Ticks) {
+	if ((Ctx.ClocksPerTick == 0) || (Ticks == 0))
+		return;
+
+	catchUp();
+	uint64_t target = Ctx.NextTickClocks + (uint64_t)(Ticks - 1) * Ctx.ClocksPerTick;
+
+	if (Ctx.RealTime) {
+		uint64_t sleepNs = (target - Ctx.Clocks) * NS_PER_CLOCK;
+		struct timespec pause;
+		if (sleepNs > MAX_SLEEP_NS)
+			sleepNs = MAX_SLEEP_NS;
+		pause.tv_sec = 0;
+		pause.tv_nsec = (long)sleepNs;
+		nanosleep(&pause, NULL);
+	} else if (target > Ctx.Clocks) {
+		Ctx.Clocks = target;
+	}
+	catchUp();
+}
+
+/****************************************************************************
+ Function
+     HostSim_SetRealTime
+
+ Parameters
+     bool : true to pace the clock with the wall clock
+
+ Returns
+     none
+
+ Description
+     switches between skipping ahead at once and waiting for the wall clock
+ Notes
+
+****************************************************************************/
+void HostSim_SetRealTime(bool NewRealTime) {
+	Ctx.RealTime = NewRealTime;
+	Ctx.WallStartNs = nowNs() - Ctx.Clocks * NS_PER_CLOCK;
+}
+
+/****************************************************************************
+ Function
+     HostSim_HoldClock
+
+ Parameters
+     bool : true to stop charging for work
+
+ Returns
+     none
+
+ Description
+     while the clock is held HostSim_Charge does nothing; skips and real
+		 time pacing still move it
+ Notes
+     a busy wait on the tick would never end while the clock is held
+****************************************************************************/
+void HostSim_HoldClock(bool Hold) {
+	Ctx.Held = Hold;
+}
+
+/****************************************************************************
+ Function
+     TERMIO_Init
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     turns off line buffering and echo on a terminal, and makes stdin
+		 non-blocking so keystrokes can be polled. On a terminal the clock is
+		 also paced in real time
+ Notes
+
+****************************************************************************/
+void TERMIO_Init(void) {
+	if (isatty(STDIN_FILENO)) {
+		struct termios mode;
+		tcgetattr(STDIN_FILENO, &mode);
+		mode.c_lflag &= ~(ICANON | ECHO);
+		tcsetattr(STDIN_FILENO, TCSANOW, &mode);
+		// someone is typing, so game time has to match their time
+		HostSim_SetRealTime(true);
+	}
+	fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+	setvbuf(stdout, NULL, _IONBF, 0);
+	ConsoleOpen = true;
+}
+
+/****************************************************************************
+ Function
+     IsNewKeyReady
+
+ Parameters
+     none
+
+ Returns
+     bool, true if a keystroke is waiting
+
+ Description
+     polls stdin for one keystroke and holds on to it
+ Notes
+     always false until TERMIO_Init has been called
+
+****************************************************************************/
+bool IsNewKeyReady(void) {
+	if (ConsoleOpen && (PendingKey == NO_KEY)) {
+		unsigned char key;
+		if (read(STDIN_FILENO, &key, 1) == 1)
+			PendingKey = key;
+	}
+	return (PendingKey != NO_KEY);
+}
+
+/****************************************************************************
+ Function
+     GetNewKey
+
+ Parameters
+     none
+
+ Returns
+     char : the waiting keystroke
+
+ Description
+     returns the keystroke found by IsNewKeyReady
+ Notes
+
+****************************************************************************/
+char GetNewKey(void) {
+	char key = (char)PendingKey;
+	PendingKey = NO_KEY;
+	return key;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// counts the ticks the SysTick interrupt would have taken by now
+static void catchUp(void) {
+	if (Ctx.RealTime) {
+		uint64_t wallClocks = (nowNs() - Ctx.WallStartNs) / NS_PER_CLOCK;
+		if (wallClocks > Ctx.Clocks)
+			Ctx.Clocks = wallClocks;
+	}
+	if ((Ctx.ClocksPerTick == 0) || (Ctx.Clocks < Ctx.NextTickClocks))
+		return;
+
+	uint64_t ticks = (Ctx.Clocks - Ctx.NextTickClocks) / Ctx.ClocksPerTick + 1;
+	Ctx.NextTickClocks += ticks * Ctx.ClocksPerTick;
+	Ctx.TickCount += (uint32_t)ticks;
+	Ctx.SysTickCounter += (uint32_t)ticks;
+}
+
+static uint64_t nowNs(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
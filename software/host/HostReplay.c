@@ -0,0 +1,313 @@
+/****************************************************************************
+ Module
+   HostReplay.c
+
+ Revision
+   1.0.1
+
+ Description
+   Plays an event trace back through the host build: the recorded stimuli
+	 are posted in place of the event checkers, and the trace the station
+	 makes meanwhile is checked against the recorded one (see HostReplay.h).
+
+ Notes
+   A stimulus is posted at the first poll that is both at or past its tick
+	 and after every record before it has been made again. That puts it in
+	 the same pass of the framework loop the event checkers posted it in.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "EventTrace.h"
+#include "HostSim.h"
+#include "KeyPadFSM.h"
+#include "HostStation.h"
+#include "HostReplay.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// this module's part of the running station
+#define Ctx (pStation->Replay)
+
+// ticks run between comparisons, well short of filling the ring
+#define CHUNK_TICKS 1000
+// bytes taken off the ring at a time for comparing
+#define COMPARE_SIZE 256
+
+/*---------------------------- Module Functions ---------------------------*/
+static void postStimuli(void);
+static void findStimulus(uint32_t Index);
+static bool compareMade(const uint8_t *pTrace, uint32_t Length,
+		uint32_t *pCompared);
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostReplay_Collect
+
+ Parameters
+     uint8_t * : the trace so far
+		 uint32_t : bytes in it so far
+		 uint32_t : room for the trace
+
+ Returns
+     uint32_t : bytes in the trace now
+
+ Description
+     empties the running station's ring onto the end of a trace
+ Notes
+     records that do not fit are left in the ring
+****************************************************************************/
+uint32_t HostReplay_Collect(uint8_t *pTrace, uint32_t Length, uint32_t Size) {
+	uint16_t moved;
+
+	do {
+		uint32_t room = Size - Length;
+		if (room > UINT16_MAX)
+			room = UINT16_MAX;
+		moved = EventTrace_Read(&pTrace[Length], (uint16_t)room);
+		Length += moved;
+	} while (moved > 0);
+	return Length;
+}
+
+/****************************************************************************
+ Function
+     HostReplay_Run
+
+ Parameters
+     HostStation_t * : station to replay on
+		 const uint8_t * : the trace
+		 uint32_t : bytes in the trace
+		 uint32_t * : where to put the offset of the first difference
+
+ Returns
+     bool : true if the replay made the same trace
+
+ Description
+     resets and selects the station, then runs it to the tick of the last
+		 record, posting the stimuli of the trace and comparing as it goes
+ Notes
+     leaves the station selected, with the event checkers back in place
+****************************************************************************/
+bool HostReplay_Run(HostStation_t *pThis, const uint8_t *pTrace,
+		uint32_t Length, uint32_t *pMismatch) {
+	uint32_t offset = 0;
+	uint32_t startTick, endTick;
+	uint32_t compared = 0;
+	EventRecord_t record;
+
+	*pMismatch = 0;
+	if (!EventTrace_DecodeStart(pTrace, Length, &offset, &startTick))
+		return false;
+	uint32_t firstRecord = offset;
+	record.Tick = startTick;
+	while (EventTrace_Decode(pTrace, Length, &offset, &record)) {
+	}
+	if (offset != Length) {
+		// the last record is cut short
+		*pMismatch = offset;
+		return false;
+	}
+	endTick = record.Tick;
+
+	HostStation_Init(pThis);
+	HostStation_Select(pThis);
+	Ctx.pTrace = pTrace;
+	Ctx.Length = Length;
+	Ctx.Offset = firstRecord;
+	Ctx.Next.Tick = startTick;
+	findStimulus(0);
+
+	HostSim_SetStimulus(postStimuli);
+	EventTrace_Start(HostSim_GetTicks());
+	if (ES_Initialize(ES_Timer_RATE_1mS) != Success) {
+		HostSim_SetStimulus(NULL);
+		return false;
+	}
+
+	while (compared < Length) {
+		uint32_t now = HostSim_GetTicks();
+		if ((int32_t)(now - endTick) > 0)
+			break; // the last record should have been made by now
+
+		// stop at the next stimulus, so the idle skip cannot jump it
+		uint32_t until = now + CHUNK_TICKS;
+		if (Ctx.HaveNext && ((int32_t)(Ctx.Next.Tick - now) > 0)
+				&& ((int32_t)(Ctx.Next.Tick - until) < 0))
+			until = Ctx.Next.Tick;
+		if ((int32_t)(endTick + 1 - until) < 0)
+			until = endTick + 1;
+
+		if (HostSim_RunUntil(until) != Success)
+			break;
+		if (!compareMade(pTrace, Length, &compared))
+			break;
+	}
+
+	HostSim_SetStimulus(NULL);
+	EventTrace_Stop();
+	*pMismatch = compared;
+	return (compared >= Length);
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// posts every stimulus that is due, in the event checkers' place
+static void postStimuli(void) {
+	while (Ctx.HaveNext && ((int32_t)(HostSim_GetTicks() - Ctx.Next.Tick) >= 0)
+			&& (EventTrace_Count() >= Ctx.NextIndex)) {
+		if (Ctx.Next.Event.EventType == KEYPAD_KEYS) {
+			// a key the key pad scan found; PutKeyPadKey records it again
+			PutKeyPadKey(Ctx.Next.Event.EventParam & ~KEYPAD_KEY_DOWN,
+					(Ctx.Next.Event.EventParam & KEYPAD_KEY_DOWN) != 0);
+		} else {
+			ES_PostToService(Ctx.Next.Service, Ctx.Next.Event);
+		}
+		findStimulus(Ctx.NextIndex + 1);
+	}
+}
+
+// moves on to the next stimulus; Index is the number of the record at
+// Ctx.Offset
+static void findStimulus(uint32_t Index) {
+	Ctx.HaveNext = false;
+	while (EventTrace_Decode(Ctx.pTrace, Ctx.Length, &Ctx.Offset, &Ctx.Next)) {
+		if (Ctx.Next.Stimulus) {
+			Ctx.NextIndex = Index;
+			Ctx.HaveNext = true;
+			return;
+		}
+		Index++;
+	}
+}
+
+// checks what the station recorded since last time against the trace
+static bool compareMade(const uint8_t *pTrace, uint32_t Length,
+		uint32_t *pCompared) {
+	uint8_t made[COMPARE_SIZE];
+	uint16_t size;
+
+	while ((size = EventTrace_Read(made, sizeof(made))) > 0) {
+		for (uint16_t i = 0; (i < size) && (*pCompared < Length); i++) {
+			if (made[i] != pTrace[*pCompared])
+				return false;
+			(*pCompared)++;
+		}
+	}
+	return (EventTrace_Lost() == 0);
+}
+
+#ifdef TEST
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "HostHAL.h"
+
+#define TRACE_SIZE 8192
+
+/* records a scripted game (three hands on, a wrong password typed in, let
+   go, back on, then the disarm timer runs out), replays it and times the
+   replays, then checks that a trace with one stimulus a tick off is
+   caught */
+static HostStation_t Recorder;
+static HostStation_t Player;
+static uint8_t Trace[TRACE_SIZE];
+static uint8_t NextKey;
+
+// runs the event checkers, and hands each key of a wrong password (1 2 3 4
+// Enter) on at its tick, the way the key pad scan does
+static void typeKeys(void) {
+	// tick each key goes down at; it comes up 60 ticks later
+	static const struct { uint32_t Tick; uint8_t Key; } Keys[] = {
+		{2000, 0}, {2200, 1}, {2400, 2}, {2600, 3}, {2800, 11}
+	};
+
+	ES_CheckUserEvents();
+	while ((NextKey < 2 * sizeof(Keys) / sizeof(Keys[0]))
+			&& ((int32_t)(HostSim_GetTicks() - Keys[NextKey / 2].Tick
+					- (NextKey % 2) * 60) >= 0)) {
+		PutKeyPadKey(Keys[NextKey / 2].Key, (NextKey % 2) == 0);
+		NextKey++;
+	}
+}
+
+static uint32_t recordGame(void) {
+	// tick each change of the tape sensors happens at, and the level
+	static const struct { uint32_t Tick; bool Level; } Script[] = {
+		{1000, false}, {4000, true}, {6000, false}, {40000, true}
+	};
+	uint32_t length = 0;
+
+	HostStation_Init(&Recorder);
+	HostStation_Select(&Recorder);
+	NextKey = 0;
+	HostSim_SetStimulus(typeKeys);
+	EventTrace_Start(HostSim_GetTicks());
+	ES_Initialize(ES_Timer_RATE_1mS);
+	for (uint8_t i = 0; i < sizeof(Script) / sizeof(Script[0]); i++) {
+		while ((int32_t)(HostSim_GetTicks() - Script[i].Tick) < 0) {
+			HostSim_RunUntil(HostSim_GetTicks() + CHUNK_TICKS < Script[i].Tick ?
+					HostSim_GetTicks() + CHUNK_TICKS : Script[i].Tick);
+			length = HostReplay_Collect(Trace, length, TRACE_SIZE);
+		}
+		// the tape sensors read LO when all three are covered
+		HostHAL_SetInput(GPIO_PORTD_BASE, GPIO_PIN_7, Script[i].Level);
+	}
+	HostSim_RunUntil(HostSim_GetTicks() + 100);
+	HostSim_SetStimulus(NULL);
+	EventTrace_Stop();
+	return HostReplay_Collect(Trace, length, TRACE_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t numReplays = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100;
+	uint32_t mismatch;
+	struct timespec start, end;
+
+	fprintf(stderr, "\n\rIn Test Harness for the replayer\r\n");
+	// the firmware's own printouts would swamp the report
+	freopen("/dev/null", "w", stdout);
+
+	uint32_t length = recordGame();
+	fprintf(stderr, "recorded %u events in %u bytes, %u lost\r\n",
+			(unsigned)EventTrace_Count(), (unsigned)length, (unsigned)EventTrace_Lost());
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < numReplays; i++) {
+		if (!HostReplay_Run(&Player, Trace, length, &mismatch)) {
+			fprintf(stderr, "replay %u differs at byte %u\r\n", (unsigned)i, (unsigned)mismatch);
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, "%u replays in %.3f s (%.0f replays/s)\r\n",
+			(unsigned)numReplays, seconds, numReplays / seconds);
+
+	// put the first stimulus one tick off
+	uint32_t offset = 0, tick;
+	EventRecord_t record;
+	EventTrace_DecodeStart(Trace, length, &offset, &tick);
+	record.Tick = tick;
+	uint32_t at = offset;
+	while (EventTrace_Decode(Trace, length, &offset, &record) && !record.Stimulus) {
+		at = offset;
+	}
+	Trace[at] ^= 1 << 5;
+	if (HostReplay_Run(&Player, Trace, length, &mismatch)) {
+		fprintf(stderr, "a moved stimulus was not caught\r\n");
+		return 1;
+	}
+	fprintf(stderr, "moved stimulus at byte %u caught at byte %u\r\n",
+			(unsigned)at, (unsigned)mismatch);
+	return 0;
+}
+#endif
@@ -0,0 +1,53 @@
+/****************************************************************************
+
+  Header file for HostReplay.c -- plays an event trace back on the host
+
+ ****************************************************************************/
+
+#ifndef HOST_REPLAY_H
+#define HOST_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "HostStation.h"
+
+/* NOTES:
+
+	A trace (EventTrace.h) holds every event posted during a game, with the
+	ones the event checkers posted marked as stimuli. HostReplay_Run starts
+	a fresh station, records it, and instead of running the event checkers
+	posts each recorded stimulus at its tick, once every record before it
+	has come out again. Everything else has to follow by itself, so the
+	station's own trace is compared with the recorded one byte for byte as
+	it is made; the first difference is where the replay went another way.
+
+	A trace recorded on the host in virtual time (scripts, HostRunner)
+	replays exactly. To record one, start the station with HostStation_Init,
+	call EventTrace_Start(HostSim_GetTicks()) before ES_Initialize, and pick
+	the bytes up with HostReplay_Collect often enough that the ring never
+	fills (once a second of game time is plenty).
+
+	Traces from the Tiva or from a real time session replay the same
+	stimuli, but the services may take a different number of clocks there,
+	so they can drift by a tick and stop matching; the mismatch still shows
+	how far the replay got.
+
+	What the event checkers posted is replayed by posting it again. Keys on
+	the key pad are recorded as they come out of the debouncer, and are
+	replayed by handing them to PutKeyPadKey, the way the scan would. The
+	debug keys 'q' 'w' 'e' drive the motor directly and do not come back.
+*/
+
+// Public Function Prototypes
+
+// appends whatever the running station has recorded to pTrace, which
+// already holds Length of its Size bytes; returns the new length
+uint32_t HostReplay_Collect(uint8_t *pTrace, uint32_t Length, uint32_t Size);
+
+// replays a trace on pThis (which is reset and selected), returns true if
+// it came out the same; otherwise *pMismatch is the offset of the first
+// byte that differs
+bool HostReplay_Run(HostStation_t *pThis, const uint8_t *pTrace,
+		uint32_t Length, uint32_t *pMismatch);
+
+#endif /* HOST_REPLAY_H */
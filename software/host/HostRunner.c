@@ -0,0 +1,309 @@
+/****************************************************************************
+ Module
+   HostRunner.c
+
+ Revision
+   1.0.1
+
+ Description
+   Runs many stations side by side for soak testing. The stations are
+	 shared out over worker threads, each with a deque of stations, and idle
+	 workers steal from busy ones (see HostRunner.h).
+
+ Notes
+   A station is only ever run by one worker at a time: it is either in
+	 exactly one deque or being run by the worker that took it out.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "HostSim.h"
+#include "HostStation.h"
+#include "HostRunner.h"
+
+/*---------------------------- Module Types -------------------------------*/
+// one worker's stations. The owner works at the Bottom end, thieves take
+// from the Top end; both only grow, the slot is the count modulo Capacity
+typedef struct {
+	pthread_mutex_t Lock;
+	uint32_t *pStations;
+	uint32_t Capacity;
+	uint32_t Top;
+	uint32_t Bottom;
+} Deque_t;
+
+typedef struct {
+	uint32_t Index;
+	pthread_t Thread;
+} Worker_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void *workerMain(void *pArg);
+static bool runSlice(uint32_t Station);
+static void pushBottom(Deque_t *pDeque, uint32_t Station);
+static bool popBottom(Deque_t *pDeque, uint32_t *pStation);
+static bool stealTop(Deque_t *pDeque, uint32_t *pStation);
+
+/*---------------------------- Module Variables ---------------------------*/
+// set up by HostRunner_Run for the workers to share
+static HostStation_t *Stations;
+static bool *Started;
+static Deque_t *Deques;
+static uint32_t NumDeques;
+static uint32_t Slice;
+static HostScript_t *Script;
+
+static atomic_uint Unfinished;
+static atomic_uint Failures;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostRunner_Run
+
+ Parameters
+     uint32_t : number of stations
+		 uint32_t : number of worker threads, 0 for one per core
+		 uint32_t : framework ticks each station runs between script calls
+		 HostScript_t * : the script that drives every station
+
+ Returns
+     uint32_t : number of stations that failed
+
+ Description
+     deals the stations out to the workers, runs them all to the end of the
+		 script and waits for the workers to finish
+ Notes
+     not reentrant: one run at a time
+****************************************************************************/
+uint32_t HostRunner_Run(uint32_t NumStations, uint32_t NumWorkers,
+		uint32_t SliceTicks, HostScript_t *pScript) {
+	if (NumWorkers == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		NumWorkers = (cores > 0) ? (uint32_t)cores : 1;
+	}
+	if (NumWorkers > NumStations)
+		NumWorkers = NumStations;
+	if (NumWorkers == 0)
+		return 0;
+
+	Stations = calloc(NumStations, sizeof(HostStation_t));
+	Started = calloc(NumStations, sizeof(bool));
+	Deques = calloc(NumWorkers, sizeof(Deque_t));
+	Worker_t *workers = calloc(NumWorkers, sizeof(Worker_t));
+	if ((Stations == NULL) || (Started == NULL) || (Deques == NULL) || (workers == NULL)) {
+		printf("HostRunner: out of memory for %u stations\r\n", (unsigned)NumStations);
+		exit(EXIT_FAILURE);
+	}
+	NumDeques = NumWorkers;
+	Slice = (SliceTicks == 0) ? 1 : SliceTicks;
+	Script = pScript;
+	atomic_store(&Unfinished, NumStations);
+	atomic_store(&Failures, 0);
+
+	// any deque may end up holding every station
+	for (uint32_t i = 0; i < NumWorkers; i++) {
+		pthread_mutex_init(&Deques[i].Lock, NULL);
+		Deques[i].pStations = calloc(NumStations, sizeof(uint32_t));
+		Deques[i].Capacity = NumStations;
+		if (Deques[i].pStations == NULL) {
+			printf("HostRunner: out of memory for %u stations\r\n", (unsigned)NumStations);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (uint32_t i = 0; i < NumStations; i++) {
+		pushBottom(&Deques[i % NumWorkers], i);
+	}
+
+	for (uint32_t i = 0; i < NumWorkers; i++) {
+		workers[i].Index = i;
+		pthread_create(&workers[i].Thread, NULL, workerMain, &workers[i]);
+	}
+	for (uint32_t i = 0; i < NumWorkers; i++) {
+		pthread_join(workers[i].Thread, NULL);
+	}
+
+	for (uint32_t i = 0; i < NumWorkers; i++) {
+		pthread_mutex_destroy(&Deques[i].Lock);
+		free(Deques[i].pStations);
+	}
+	free(workers);
+	free(Deques);
+	free(Started);
+	free(Stations);
+	return atomic_load(&Failures);
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// runs stations, its own first, until every station is finished
+static void *workerMain(void *pArg) {
+	Worker_t *pSelf = pArg;
+	Deque_t *pOwn = &Deques[pSelf->Index];
+	uint32_t station;
+
+	while (atomic_load(&Unfinished) > 0) {
+		bool found = popBottom(pOwn, &station);
+		for (uint32_t i = 1; !found && (i < NumDeques); i++) {
+			found = stealTop(&Deques[(pSelf->Index + i) % NumDeques], &station);
+		}
+		if (!found) {
+			// the last stations are all being run by other workers
+			sched_yield();
+			continue;
+		}
+
+		if (runSlice(station))
+			pushBottom(pOwn, station);
+		else
+			atomic_fetch_sub(&Unfinished, 1);
+	}
+	return NULL;
+}
+
+// runs one slice of a station, starting it first if need be, and returns
+// false once it is finished
+static bool runSlice(uint32_t Station) {
+	HostStation_t *pThis = &Stations[Station];
+
+	if (!Started[Station]) {
+		Started[Station] = true;
+		HostStation_Init(pThis);
+		HostStation_Select(pThis);
+		if (ES_Initialize(ES_Timer_RATE_1mS) != Success) {
+			atomic_fetch_add(&Failures, 1);
+			return false;
+		}
+	}
+
+	HostStation_Select(pThis);
+	if (!Script(Station))
+		return false;
+	if (HostSim_RunUntil(HostSim_GetTicks() + Slice) != Success) {
+		atomic_fetch_add(&Failures, 1);
+		return false;
+	}
+	return true;
+}
+
+static void pushBottom(Deque_t *pDeque, uint32_t Station) {
+	pthread_mutex_lock(&pDeque->Lock);
+	pDeque->pStations[pDeque->Bottom % pDeque->Capacity] = Station;
+	pDeque->Bottom++;
+	pthread_mutex_unlock(&pDeque->Lock);
+}
+
+static bool popBottom(Deque_t *pDeque, uint32_t *pStation) {
+	bool found = false;
+
+	pthread_mutex_lock(&pDeque->Lock);
+	if (pDeque->Bottom != pDeque->Top) {
+		pDeque->Bottom--;
+		*pStation = pDeque->pStations[pDeque->Bottom % pDeque->Capacity];
+		found = true;
+	}
+	pthread_mutex_unlock(&pDeque->Lock);
+	return found;
+}
+
+static bool stealTop(Deque_t *pDeque, uint32_t *pStation) {
+	bool found = false;
+
+	pthread_mutex_lock(&pDeque->Lock);
+	if (pDeque->Bottom != pDeque->Top) {
+		*pStation = pDeque->pStations[pDeque->Top % pDeque->Capacity];
+		pDeque->Top++;
+		found = true;
+	}
+	pthread_mutex_unlock(&pDeque->Lock);
+	return found;
+}
+
+#ifdef TEST
+#include <time.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "HostHAL.h"
+#include "DisarmFSM.h"
+
+#define GAMES_PER_STATION 2
+
+/* soak test: every station puts three hands on the tape sensors, lets the
+   disarm timer run out, lets go, and does that GAMES_PER_STATION times */
+typedef enum { WaitToStart, WaitForStage1, WaitForTimeout } Phase_t;
+
+static Phase_t *Phases;
+static uint32_t *StartTicks;
+static uint8_t *Games;
+static atomic_uint GamesPlayed;
+
+static bool soakScript(uint32_t Station) {
+	uint32_t now = HostSim_GetTicks();
+
+	switch (Phases[Station]) {
+		case WaitToStart:
+			if (Games[Station] == GAMES_PER_STATION)
+				return false;
+			if (StartTicks[Station] == 0)
+				StartTicks[Station] = now + 500 + (Station % 1000);
+			if ((int32_t)(now - StartTicks[Station]) >= 0) {
+				// the tape sensors read LO when all three are covered
+				HostHAL_SetInput(GPIO_PORTD_BASE, GPIO_PIN_7, false);
+				Phases[Station] = WaitForStage1;
+			}
+			break;
+
+		case WaitForStage1:
+			if (QueryDisarmFSM() == Stage1)
+				Phases[Station] = WaitForTimeout;
+			break;
+
+		case WaitForTimeout:
+			// the disarm timer ran out and the FSM re-armed
+			if (QueryDisarmFSM() == Armed) {
+				HostHAL_SetInput(GPIO_PORTD_BASE, GPIO_PIN_7, true);
+				Games[Station]++;
+				atomic_fetch_add(&GamesPlayed, 1);
+				StartTicks[Station] = now + 100;
+				Phases[Station] = WaitToStart;
+			}
+			break;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t numStations = (argc > 1) ? (uint32_t)atoi(argv[1]) : 1000;
+	uint32_t numWorkers = (argc > 2) ? (uint32_t)atoi(argv[2]) : 0;
+	struct timespec start, end;
+
+	fprintf(stderr, "\n\rIn Test Harness for the host runner\r\n");
+	Phases = calloc(numStations, sizeof(Phase_t));
+	StartTicks = calloc(numStations, sizeof(uint32_t));
+	Games = calloc(numStations, sizeof(uint8_t));
+	// the firmware's own printouts would swamp the report
+	freopen("/dev/null", "w", stdout);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	uint32_t failures = HostRunner_Run(numStations, numWorkers, 1000, soakScript);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, "%u stations, %u games, %u failures in %.2f s (%.0f games/hour)\r\n",
+			(unsigned)numStations, (unsigned)atomic_load(&GamesPlayed), (unsigned)failures,
+			seconds, atomic_load(&GamesPlayed) * 3600.0 / seconds);
+	return (failures == 0) ? 0 : 1;
+}
+#endif
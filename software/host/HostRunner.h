@@ -0,0 +1,43 @@
+/****************************************************************************
+
+  Header file for HostRunner.c -- many stations on many threads
+
+ ****************************************************************************/
+
+#ifndef HOST_RUNNER_H
+#define HOST_RUNNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* NOTES:
+
+	HostRunner_Run plays NumStations independent stations, spread over
+	NumWorkers threads (0 for one per core). Each station is run in slices of
+	SliceTicks framework ticks. Before every slice the script is called with
+	that station selected, so it can drive the inputs (HostHAL_SetInput,
+	HostHAL_SetADC) and look at the firmware (QueryDisarmFSM,
+	HostSim_GetTicks). It returns false once the station is done.
+
+	Work stealing
+	----------------------------------------
+	Every worker keeps a deque of the stations it holds. It runs the newest
+	one from its own end and, when that end is empty, takes the oldest one
+	from another worker's. Stations start dealt out evenly, and a worker
+	that finishes early keeps busy by taking stations off the slow ones.
+
+	The firmware prints to stdout from every station, so send stdout to
+	/dev/null for big runs. Link with -pthread.
+*/
+
+// drives the inputs of a station before a slice; false once it is finished
+typedef bool HostScript_t(uint32_t Station);
+
+// Public Function Prototypes
+
+// runs every station to the end of its script and returns how many of them
+// failed to initialize or returned ES_ERROR from a service
+uint32_t HostRunner_Run(uint32_t NumStations, uint32_t NumWorkers,
+		uint32_t SliceTicks, HostScript_t *pScript);
+
+#endif /* HOST_RUNNER_H */
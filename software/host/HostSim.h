@@ -0,0 +1,93 @@
+/****************************************************************************
+
+  Header file for the host simulation controls
+  (HostPort.c, HostTimers.c and HostFramework.c)
+
+ ****************************************************************************/
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ES_Framework.h"
+
+/* NOTES:
+
+	Time on the host is a simulated 40MHz clock. It only moves when the
+	firmware does something that takes time on the Tiva: each register
+	access and each read of the tick counter is charged a few clocks, so
+	busy waits such as wait() still finish. The framework tick is derived
+	from this clock at whatever rate _HW_Timer_Init last set.
+
+	When every queue is empty and no event checker fired, the host loop
+	jumps the clock straight to the next timer expiry instead of spinning,
+	so a 60 second DISARM_TIMER costs the same as any other event.
+
+	For interactive use (stdin is a terminal) TERMIO_Init turns on real time
+	pacing, which makes those jumps wait for the wall clock instead.
+
+	The event checkers are not charged for: the clock is held while they
+	run. That way a replay (host/HostReplay.h), which posts the recorded
+	stimuli in place of running the checkers, keeps exactly the same clock.
+*/
+
+// clocks charged for one register access through HWREG
+#define HOST_CLOCKS_PER_ACCESS 4
+// clocks charged for one read of the tick counter
+#define HOST_CLOCKS_PER_TICK_READ 16
+
+// Public Function Prototypes
+
+/* simulated clock (HostPort.c) */
+
+// resets the clock and the tick to zero and turns the tick off
+void HostSim_ResetClock(void);
+
+// advances the clock by the time some piece of work would take
+void HostSim_Charge(uint32_t Clocks);
+
+// returns the clocks since reset
+uint64_t HostSim_GetClocks(void);
+
+// returns the ticks since reset
+uint32_t HostSim_GetTicks(void);
+
+// moves the clock forward to the Nth tick from now
+void HostSim_SkipTicks(uint32_t Ticks);
+
+// makes clock jumps wait for the wall clock (true) or happen at once (false)
+void HostSim_SetRealTime(bool RealTime);
+
+// while held (true), charges are ignored and the clock only moves by jumps
+void HostSim_HoldClock(bool Hold);
+
+/* timers (HostTimers.c) */
+
+// returns true and the ticks until the earliest running timer expires,
+// false if no timer is running
+bool HostSim_NextExpiry(uint32_t *pTicks);
+
+// returns true and the ticks until timer Num expires, false if it is not
+// running
+bool HostSim_TimeLeft(uint8_t Num, uint32_t *pTicks);
+
+// counts Ticks ticks of the timer module, as that many calls to
+// ES_Timer_Tick_Resp would
+void HostSim_CountTicks(uint32_t Ticks);
+
+/* framework (HostFramework.c) */
+
+// polled in place of the event checkers, posts whatever events are due
+typedef void HostStimulus_t(void);
+
+// runs the framework until the tick count reaches Tick and returns
+ES_Return_t HostSim_RunUntil(uint32_t Tick);
+
+// runs the services until every queue is empty and returns
+ES_Return_t HostSim_RunPending(void);
+
+// polls pSource instead of the event checkers, or the checkers again (NULL)
+void HostSim_SetStimulus(HostStimulus_t *pSource);
+
+#endif /* HOST_SIM_H */
@@ -0,0 +1,78 @@
+/****************************************************************************
+ Module
+   HostStation.c
+
+ Description
+   Holds the station each thread is running, and the default station used
+	 by main.c and the test harnesses.
+
+ Notes
+   The default station pairs with the firmware's own default context, so a
+	 program that never selects a station behaves exactly like one board.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "HostStation.h"
+
+/*---------------------------- Module Variables ---------------------------*/
+// power on state of the hardware: inputs released (HI), nothing pending
+static const HostStation_t PowerOn = {
+	.HAL = {
+		.PortInput = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+		.PendingPort = HOST_NO_PORT
+	}
+};
+
+static HostStation_t Default = {
+	.HAL = {
+		.PortInput = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+		.PendingPort = HOST_NO_PORT
+	}
+};
+
+CONTEXT_LOCAL HostStation_t *pStation = &Default;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostStation_Init
+
+ Parameters
+     HostStation_t * : the station to reset
+
+ Returns
+     none
+
+ Description
+     puts the simulated hardware of a station to power on and gives its
+		 firmware context its power on values
+ Notes
+     does not select the station
+****************************************************************************/
+void HostStation_Init(HostStation_t *pNewStation) {
+	*pNewStation = PowerOn;
+	GameContext_Init(&pNewStation->Game);
+}
+
+/****************************************************************************
+ Function
+     HostStation_Select
+
+ Parameters
+     HostStation_t * : the station to run
+
+ Returns
+     none
+
+ Description
+     points both the host modules and the firmware at the given station for
+		 the calling thread
+ Notes
+
+****************************************************************************/
+void HostStation_Select(HostStation_t *pNewStation) {
+	pStation = pNewStation;
+	GameContext_Select(&pNewStation->Game);
+}
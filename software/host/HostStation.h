@@ -0,0 +1,290 @@
+/****************************************************************************
+
+  Header file for HostStation.c -- one simulated board
+
+ ****************************************************************************/
+
+#ifndef HOST_STATION_H
+#define HOST_STATION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "GameContext.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostWave.h"
+#include "HostLCD.h"
+
+/* NOTES:
+
+	A station is everything one simulated board owns: the firmware's
+	GameContext_t plus the state of the host modules standing in for the
+	hardware (register file and pins, clock, framework timers and queues,
+	the trace being replayed, the waveform being captured and the LCD).
+	Each host module reaches its own part through pStation, which is thread
+	local like pGame, so any number of stations can exist and each thread
+	runs whichever one it last selected.
+
+	main.c and the module test harnesses never select a station and run on
+	the default one. HostRunner.c runs many stations on many threads.
+
+	A station must not be moved or copied after ES_Initialize, as its queues
+	point into its own queue pool.
+*/
+
+#define HOST_NUM_PORTS 6
+#define HOST_NUM_REGS 256 // must be a power of 2
+#define HOST_NO_PORT 0xff
+#define HOST_NUM_TIMERS 16
+
+/* the queue pool holds every service's queue, as in ES_Framework.c */
+#if NUM_SERVICES > 1
+#define HOST_QUEUE_SIZE_1 SERV_1_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_1 0
+#endif
+#if NUM_SERVICES > 2
+#define HOST_QUEUE_SIZE_2 SERV_2_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_2 0
+#endif
+#if NUM_SERVICES > 3
+#define HOST_QUEUE_SIZE_3 SERV_3_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_3 0
+#endif
+#if NUM_SERVICES > 4
+#define HOST_QUEUE_SIZE_4 SERV_4_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_4 0
+#endif
+#if NUM_SERVICES > 5
+#define HOST_QUEUE_SIZE_5 SERV_5_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_5 0
+#endif
+#if NUM_SERVICES > 6
+#define HOST_QUEUE_SIZE_6 SERV_6_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_6 0
+#endif
+#if NUM_SERVICES > 7
+#define HOST_QUEUE_SIZE_7 SERV_7_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_7 0
+#endif
+#if NUM_SERVICES > 8
+#define HOST_QUEUE_SIZE_8 SERV_8_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_8 0
+#endif
+#if NUM_SERVICES > 9
+#define HOST_QUEUE_SIZE_9 SERV_9_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_9 0
+#endif
+#if NUM_SERVICES > 10
+#define HOST_QUEUE_SIZE_10 SERV_10_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_10 0
+#endif
+#if NUM_SERVICES > 11
+#define HOST_QUEUE_SIZE_11 SERV_11_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_11 0
+#endif
+#if NUM_SERVICES > 12
+#define HOST_QUEUE_SIZE_12 SERV_12_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_12 0
+#endif
+#if NUM_SERVICES > 13
+#define HOST_QUEUE_SIZE_13 SERV_13_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_13 0
+#endif
+#if NUM_SERVICES > 14
+#define HOST_QUEUE_SIZE_14 SERV_14_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_14 0
+#endif
+#if NUM_SERVICES > 15
+#define HOST_QUEUE_SIZE_15 SERV_15_QUEUE_SIZE
+#else
+#define HOST_QUEUE_SIZE_15 0
+#endif
+
+#define HOST_QUEUE_POOL_SIZE (SERV_0_QUEUE_SIZE + HOST_QUEUE_SIZE_1 + HOST_QUEUE_SIZE_2 + HOST_QUEUE_SIZE_3 \
+		+ HOST_QUEUE_SIZE_4 + HOST_QUEUE_SIZE_5 + HOST_QUEUE_SIZE_6 + HOST_QUEUE_SIZE_7 \
+		+ HOST_QUEUE_SIZE_8 + HOST_QUEUE_SIZE_9 + HOST_QUEUE_SIZE_10 + HOST_QUEUE_SIZE_11 \
+		+ HOST_QUEUE_SIZE_12 + HOST_QUEUE_SIZE_13 + HOST_QUEUE_SIZE_14 + HOST_QUEUE_SIZE_15)
+
+// one register of the register file
+typedef struct {
+	uint32_t Address;
+	uint32_t Value;
+	bool Used;
+} HostReg_t;
+
+// one service's queue
+typedef struct {
+	ES_Event *pBuffer; // this service's slice of the queue pool
+	uint8_t Size;
+	uint8_t Head;
+	uint8_t Count;
+} HostQueue_t;
+
+// HostHAL.c
+typedef struct {
+	// every register that is not a GPIO data register
+	HostReg_t Regs[HOST_NUM_REGS];
+	// output latch and external level of each GPIO port
+	uint8_t PortLatch[HOST_NUM_PORTS];
+	uint8_t PortInput[HOST_NUM_PORTS];
+	// the word handed out for GPIO data accesses, and what it was handed out for
+	uint32_t DataWindow;
+	uint8_t PendingPort;
+	uint8_t PendingMask;
+	uint32_t CycleCount; // the word handed out for DWT CYCCNT reads
+	// ADC and PWM state for the course libraries
+	uint16_t ADCValue;
+	uint16_t PulseWidths[HOST_NUM_PWM_CHANNELS];
+} HostHALContext_t;
+
+// HostPort.c
+typedef struct {
+	uint64_t Clocks; // simulated clocks since reset
+	uint64_t ClocksPerTick; // 0 while the tick is off
+	uint64_t NextTickClocks; // clock count the next tick happens at
+	uint32_t TickCount; // ticks not yet handed to the timer module
+	uint32_t SysTickCounter; // free running tick counter
+	bool RealTime;
+	bool Held; // charges are ignored while the event checkers run
+	uint64_t WallStartNs;
+} HostClockContext_t;
+
+// HostTimers.c
+typedef struct {
+	// ticks handed to the timer module so far
+	uint32_t Time;
+	// ticks left on each timer while it is stopped
+	uint16_t Remaining[HOST_NUM_TIMERS];
+	// tick each running timer expires on
+	uint32_t Deadline[HOST_NUM_TIMERS];
+	// bit n is set while timer n is running
+	uint16_t ActiveFlags;
+	// earliest deadline of the running timers
+	uint32_t NextDeadline;
+} HostTimersContext_t;
+
+// HostFramework.c
+typedef struct {
+	ES_Event QueuePool[HOST_QUEUE_POOL_SIZE];
+	HostQueue_t Queues[NUM_SERVICES];
+	// bit n is set while service n has an event waiting
+	uint16_t Ready;
+	// true while the event checkers (or the stimulus source) run
+	bool InCheckers;
+	// polled instead of the event checkers when not NULL
+	HostStimulus_t *pStimulus;
+} HostFrameworkContext_t;
+
+// HostReplay.c
+typedef struct {
+	const uint8_t *pTrace;
+	uint32_t Length;
+	// offset just past the next stimulus to post
+	uint32_t Offset;
+	// the next stimulus, and how many records come before it
+	EventRecord_t Next;
+	uint32_t NextIndex;
+	bool HaveNext;
+} HostReplayContext_t;
+
+// one pin or mark change of a capture
+typedef struct {
+	uint64_t Clocks;
+	uint8_t Signal; // port * 8 + pin, or one of the marks after the pins
+	uint8_t Level;
+} HostWaveChange_t;
+
+// HostWave.c
+typedef struct {
+	FILE *pFile; // NULL while not capturing
+	HostWaveChange_t *pChanges;
+	uint32_t NumChanges;
+	uint32_t Size;
+	// clock and pin levels the capture starts from, the levels last seen
+	// and the pins that moved
+	uint64_t StartClocks;
+	uint8_t StartPins[HOST_NUM_PORTS];
+	uint8_t Pins[HOST_NUM_PORTS];
+	uint8_t UsedPins[HOST_NUM_PORTS];
+	char MarkNames[HOST_WAVE_MAX_MARKS][HOST_WAVE_NAME_SIZE];
+	uint8_t NumMarks;
+	uint16_t MarkLevels; // bit n is set while mark n is HI
+} HostWaveContext_t;
+
+// HostLCD.c
+typedef struct {
+	// 74HC595: pin levels last seen, shift and storage registers
+	uint8_t Pins;
+	uint8_t Shift;
+	uint8_t Outputs;
+	uint64_t DataChangedAt;
+	uint64_t SckRoseAt;
+	uint64_t RckRoseAt;
+	// HD44780 bus: when RS/RW and all the lines last moved, when E rose
+	uint64_t RSChangedAt;
+	uint64_t LinesChangedAt;
+	uint64_t ERoseAt;
+	// HD44780 state, set up at the first edge
+	bool Powered;
+	bool FourBit;
+	bool HaveHigh; // the first nibble of a byte is in High
+	uint8_t High;
+	uint8_t InitWrites; // function sets while in 8 bit mode
+	uint64_t BusyUntil;
+	uint64_t BusyTime;
+	uint8_t Address; // DDRAM or CGRAM address counter
+	bool CGMode;
+	bool Increment;
+	bool ShiftDisplay;
+	bool DisplayOn;
+	bool CursorOn;
+	bool Blink;
+	bool TwoLines;
+	uint8_t DisplayShift;
+	uint8_t DDRAM[128];
+	uint8_t CGRAM[64];
+	// timing rules broken
+	uint32_t Violations;
+	char FirstViolation[96];
+} HostLCDContext_t;
+
+typedef struct {
+	GameContext_t Game;
+	HostHALContext_t HAL;
+	HostClockContext_t Clock;
+	HostTimersContext_t Timers;
+	HostFrameworkContext_t Framework;
+	HostReplayContext_t Replay;
+	HostWaveContext_t Wave;
+	HostLCDContext_t LCD;
+} HostStation_t;
+
+// the station that is currently running on this thread
+extern CONTEXT_LOCAL HostStation_t *pStation;
+
+// Public Function Prototypes
+
+// puts a station back to power on: pins released, clock at zero, no events
+void HostStation_Init(HostStation_t *pNewStation);
+
+// makes the given station, firmware and hardware, the one this thread runs
+void HostStation_Select(HostStation_t *pNewStation);
+
+#endif /* HOST_STATION_H */
@@ -0,0 +1,324 @@
+/****************************************************************************
+ Module
+   HostTimers.c
+
+ Revision
+   1.0.1
+
+ Description
+   Host replacement for ES_Timers.c. Keeps the same 16 timers and the same
+	 rules for setting, starting and stopping them, but stores each running
+	 timer as the tick it expires on. That makes a tick with nothing expiring
+	 a single compare, and lets the host loop ask how far away the next
+	 expiry is so it can skip straight to it.
+
+ Notes
+   Timeouts are posted to the TIMERn_RESP_FUNC functions in ES_Configure.h
+	 with the timer number as the parameter, highest numbered timer first.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+#include "HostSim.h"
+#include "HostStation.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define NUM_TIMERS HOST_NUM_TIMERS
+
+// this module's part of the running station
+#define Ctx (pStation->Timers)
+
+/*---------------------------- Module Functions ---------------------------*/
+static void findNextDeadline(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static pPostFunc const Timer2PostFunc[NUM_TIMERS] = {
+	TIMER0_RESP_FUNC, TIMER1_RESP_FUNC, TIMER2_RESP_FUNC, TIMER3_RESP_FUNC,
+	TIMER4_RESP_FUNC, TIMER5_RESP_FUNC, TIMER6_RESP_FUNC, TIMER7_RESP_FUNC,
+	TIMER8_RESP_FUNC, TIMER9_RESP_FUNC, TIMER10_RESP_FUNC, TIMER11_RESP_FUNC,
+	TIMER12_RESP_FUNC, TIMER13_RESP_FUNC, TIMER14_RESP_FUNC, TIMER15_RESP_FUNC
+};
+
+// the timers of each station are kept in HostTimersContext_t (see HostStation.h)
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_Timer_Init
+
+ Parameters
+     TimerRate_t : the tick rate
+
+ Returns
+     none
+
+ Description
+     starts the tick at the given rate
+ Notes
+     running timers keep running, as DisarmFSM relies on when it re-arms
+****************************************************************************/
+void ES_Timer_Init(TimerRate_t Rate) {
+	_HW_Timer_Init(Rate);
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_SetTimer
+
+ Parameters
+     uint8_t : the timer number
+		 uint16_t : the number of ticks to count
+
+ Returns
+     ES_TimerReturn_t : ES_Timer_ERR for a bad or unused timer
+
+ Description
+     sets the time on a timer without starting it. A running timer carries
+		 on with the new time
+ Notes
+
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime) {
+	if ((Num >= NUM_TIMERS) || (NewTime == 0) || (Timer2PostFunc[Num] == TIMER_UNUSED))
+		return ES_Timer_ERR;
+
+	Ctx.Remaining[Num] = NewTime;
+	if (Ctx.ActiveFlags & (1 << Num)) {
+		Ctx.Deadline[Num] = Ctx.Time + NewTime;
+		findNextDeadline();
+	}
+	return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_StartTimer
+
+ Parameters
+     uint8_t : the timer number
+
+ Returns
+     ES_TimerReturn_t : ES_Timer_ERR for a bad timer or one with no time left
+
+ Description
+     starts a timer counting down whatever time it has left. Starting a
+		 running timer changes nothing
+ Notes
+
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num) {
+	if ((Num >= NUM_TIMERS) || (Timer2PostFunc[Num] == TIMER_UNUSED))
+		return ES_Timer_ERR;
+
+	if (Ctx.ActiveFlags & (1 << Num))
+		return ES_Timer_OK;
+	if (Ctx.Remaining[Num] == 0)
+		return ES_Timer_ERR;
+
+	Ctx.Deadline[Num] = Ctx.Time + Ctx.Remaining[Num];
+	Ctx.ActiveFlags |= (1 << Num);
+	findNextDeadline();
+	return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_StopTimer
+
+ Parameters
+     uint8_t : the timer number
+
+ Returns
+     ES_TimerReturn_t : ES_Timer_ERR for a bad timer
+
+ Description
+     stops a timer, keeping the time it had left
+ Notes
+
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num) {
+	if ((Num >= NUM_TIMERS) || (Timer2PostFunc[Num] == TIMER_UNUSED))
+		return ES_Timer_ERR;
+
+	if (Ctx.ActiveFlags & (1 << Num)) {
+		Ctx.Remaining[Num] = (uint16_t)(Ctx.Deadline[Num] - Ctx.Time);
+		Ctx.ActiveFlags &= ~(1 << Num);
+		findNextDeadline();
+	}
+	return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_InitTimer
+
+ Parameters
+     uint8_t : the timer number
+		 uint16_t : the number of ticks to count
+
+ Returns
+     ES_TimerReturn_t : ES_Timer_ERR for a bad or unused timer
+
+ Description
+     sets the time on a timer and (re)starts it
+ Notes
+
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime) {
+	if (ES_Timer_SetTimer(Num, NewTime) != ES_Timer_OK)
+		return ES_Timer_ERR;
+
+	Ctx.Deadline[Num] = Ctx.Time + NewTime;
+	Ctx.ActiveFlags |= (1 << Num);
+	findNextDeadline();
+	return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_GetTime
+
+ Parameters
+     none
+
+ Returns
+     uint16_t : the free running tick count
+
+ Description
+     returns the current tick count
+ Notes
+
+****************************************************************************/
+uint16_t ES_Timer_GetTime(void) {
+	return _HW_GetTickCount();
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_Tick_Resp
+
+ Parameters
+     none
+
+ Returns
+     none
+
+ Description
+     counts one tick and posts ES_TIMEOUT for every timer expiring on it
+ Notes
+     called by HostSim_CountTicks for every tick a timer can expire on
+****************************************************************************/
+void ES_Timer_Tick_Resp(void) {
+	Ctx.Time++;
+	if ((Ctx.ActiveFlags == 0) || (Ctx.Time != Ctx.NextDeadline))
+		return;
+
+	for (int8_t i = NUM_TIMERS - 1; i >= 0; i--) {
+		if ((Ctx.ActiveFlags & (1 << i)) && (Ctx.Deadline[i] == Ctx.Time)) {
+			ES_Event ThisEvent;
+			Ctx.ActiveFlags &= ~(1 << i);
+			Ctx.Remaining[i] = 0;
+			ThisEvent.EventType = ES_TIMEOUT;
+			ThisEvent.EventParam = i;
+			Timer2PostFunc[i](ThisEvent);
+		}
+	}
+	findNextDeadline();
+}
+
+/****************************************************************************
+ Function
+     HostSim_CountTicks
+
+ Parameters
+     uint32_t : ticks that have passed
+
+ Returns
+     none
+
+ Description
+     counts the ticks the way ES_Timer_Tick_Resp would one by one, but
+		 jumps over the ticks before the next expiry in one go
+ Notes
+     a skip over a long wait hands over thousands of ticks at a time, and
+		 counting them one by one was most of what a fuzz step cost
+****************************************************************************/
+void HostSim_CountTicks(uint32_t Ticks) {
+	while (Ticks > 0) {
+		// ticks on which no timer can expire
+		uint32_t quiet = Ticks - 1;
+		if ((Ctx.ActiveFlags != 0) && (Ctx.NextDeadline - Ctx.Time - 1 < quiet))
+			quiet = Ctx.NextDeadline - Ctx.Time - 1;
+		Ctx.Time += quiet;
+		ES_Timer_Tick_Resp();
+		Ticks -= quiet + 1;
+	}
+}
+
+/****************************************************************************
+ Function
+     HostSim_NextExpiry
+
+ Parameters
+     uint32_t * : where to put the ticks until the next expiry
+
+ Returns
+     bool, false if no timer is running
+
+ Description
+     tells the host loop how far it can skip ahead
+ Notes
+
+****************************************************************************/
+bool HostSim_NextExpiry(uint32_t *pTicks) {
+	if (Ctx.ActiveFlags == 0)
+		return false;
+
+	*pTicks = Ctx.NextDeadline - Ctx.Time;
+	return true;
+}
+
+/****************************************************************************
+ Function
+     HostSim_TimeLeft
+
+ Parameters
+     uint8_t : the timer
+		 uint32_t * : where to put the ticks until it expires
+
+ Returns
+     bool, false if the timer is not running
+
+ Description
+     lets a script run to the point where one particular timer goes off
+ Notes
+
+****************************************************************************/
+bool HostSim_TimeLeft(uint8_t Num, uint32_t *pTicks) {
+	if ((Num >= NUM_TIMERS) || ((Ctx.ActiveFlags & (1 << Num)) == 0))
+		return false;
+
+	*pTicks = Ctx.Deadline[Num] - Ctx.Time;
+	return true;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// keeps NextDeadline on the earliest running timer
+static void findNextDeadline(void) {
+	bool found = false;
+
+	for (uint8_t i = 0; i < NUM_TIMERS; i++) {
+		if ((Ctx.ActiveFlags & (1 << i)) &&
+				(!found || (Ctx.Deadline[i] - Ctx.Time < Ctx.NextDeadline - Ctx.Time))) {
+			Ctx.NextDeadline = Ctx.Deadline[i];
+			found = true;
+		}
+	}
+}
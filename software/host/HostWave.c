@@ -0,0 +1,571 @@
+/****************************************************************************
+ Module
+   HostWave.c
+
+ Revision
+   1.0.1
+
+ Description
+   Captures the pin changes of the host build with their simulated time and
+	 writes them out as VCD, and compares the marked operations of two such
+	 files (see HostWave.h).
+
+ Notes
+   The changes are kept in memory until HostWave_Close, because VCD has to
+	 declare every wire before the first change, and marks are only known
+	 once they are used.
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "HostHAL.h"
+#include "HostSim.h"
+#include "HostStation.h"
+#include "HostWave.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// one clock of the 40MHz Tiva system clock, in ns
+#define NS_PER_CLOCK 25
+#define PINS_PER_PORT 8
+// signal numbers: port pins first, then the marks
+#define FIRST_MARK (HOST_NUM_PORTS * PINS_PER_PORT)
+#define FIRST_CHANGES 4096
+// VCD identifiers are printable characters, one per signal
+#define FIRST_ID '!'
+#define MARKS_SCOPE "marks"
+#define TOKEN_SIZE 64
+
+// this module's part of the running station
+#define Ctx (pStation->Wave)
+
+/*---------------------------- Module Types -------------------------------*/
+// what a file says about one mark
+typedef struct {
+	char Name[TOKEN_SIZE]; // as the file has it, which may be longer than a mark's
+	char Id[TOKEN_SIZE];
+	uint32_t Count; // times it went HI
+	double HighNs; // time spent HI, over all of them
+	double RoseAt;
+	bool High;
+} MarkTime_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void addChange(uint8_t Signal, bool Level);
+static void writeHeader(FILE *pFile);
+static int measureFile(const char *pName, MarkTime_t *pMarks);
+static double timescaleNs(FILE *pFile);
+static void skipToEnd(FILE *pFile);
+static double averageUs(const MarkTime_t *pMark);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const uint32_t PortBases[HOST_NUM_PORTS] = {
+	GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTC_BASE,
+	GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTF_BASE
+};
+
+// the capture of each station is kept in HostWaveContext_t (see HostStation.h)
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     HostWave_Open
+
+ Parameters
+     const char * : name of the VCD file to write
+
+ Returns
+     bool : false if the file cannot be made
+
+ Description
+     starts a capture of the running station from its pins as they are now
+ Notes
+     the file is made at once, so a bad name shows up before the run
+****************************************************************************/
+bool HostWave_Open(const char *pFileName) {
+	HostWave_Close();
+
+	Ctx.pFile = fopen(pFileName, "w");
+	if (Ctx.pFile == NULL)
+		return false;
+
+	Ctx.Size = FIRST_CHANGES;
+	Ctx.pChanges = malloc(Ctx.Size * sizeof(HostWaveChange_t));
+	if (Ctx.pChanges == NULL) {
+		fclose(Ctx.pFile);
+		Ctx.pFile = NULL;
+		return false;
+	}
+	Ctx.NumChanges = 0;
+	Ctx.NumMarks = 0;
+	Ctx.MarkLevels = 0;
+	Ctx.StartClocks = HostSim_GetClocks();
+	for (uint8_t i = 0; i < HOST_NUM_PORTS; i++) {
+		Ctx.StartPins[i] = HostHAL_GetPins(PortBases[i]);
+		Ctx.Pins[i] = Ctx.StartPins[i];
+		Ctx.UsedPins[i] = 0;
+	}
+	return true;
+}
+
+/****************************************************************************
+ Function
+     HostWave_Mark
+
+ Parameters
+     const char * : name of the mark
+		 bool : true to raise it, false to lower it
+
+ Returns
+     none
+
+ Description
+     moves the mark wire, making it on first use
+ Notes
+     the register access before it is committed first, so the last write
+		 of an operation falls inside its mark
+****************************************************************************/
+void HostWave_Mark(const char *pName, bool Active) {
+	uint8_t mark;
+
+	if (Ctx.pFile == NULL)
+		return;
+
+	for (mark = 0; mark < Ctx.NumMarks; mark++) {
+		if (strncmp(Ctx.MarkNames[mark], pName, HOST_WAVE_NAME_SIZE - 1) == 0)
+			break;
+	}
+	if (mark == Ctx.NumMarks) {
+		if (Ctx.NumMarks == HOST_WAVE_MAX_MARKS)
+			return;
+		snprintf(Ctx.MarkNames[mark], HOST_WAVE_NAME_SIZE, "%s", pName);
+		Ctx.NumMarks++;
+	}
+	if (((Ctx.MarkLevels >> mark) & 1) == Active)
+		return;
+
+	// reading any port commits the access still pending in HostHAL.c
+	HostHAL_GetPins(GPIO_PORTA_BASE);
+	Ctx.MarkLevels ^= (1u << mark);
+	addChange(FIRST_MARK + mark, Active);
+}
+
+/****************************************************************************
+ Function
+     HostWave_Pins
+
+ Parameters
+     uint8_t : port index (0 is port A)
+		 uint8_t : pin levels now
+
+ Returns
+     none
+
+ Description
+     keeps one change for each pin whose level differs from the last seen
+ Notes
+     called on every GPIO data write, so it returns at once when nothing moved
+****************************************************************************/
+void HostWave_Pins(uint8_t Port, uint8_t Levels) {
+	uint8_t moved = Ctx.Pins[Port] ^ Levels;
+
+	if ((Ctx.pFile == NULL) || (moved == 0))
+		return;
+
+	Ctx.Pins[Port] = Levels;
+	Ctx.UsedPins[Port] |= moved;
+	for (uint8_t pin = 0; pin < PINS_PER_PORT; pin++) {
+		if (moved & (1 << pin))
+			addChange(Port * PINS_PER_PORT + pin, (Levels >> pin) & 1);
+	}
+}
+
+/****************************************************************************
+ Function
+     HostWave_Close
+
+ Parameters
+     none
+
+ Returns
+     bool : false if nothing was open or the file could not be written
+
+ Description
+     writes the header, the starting levels and every change, and frees
+		 the capture
+ Notes
+
+****************************************************************************/
+bool HostWave_Close(void) {
+	FILE *pFile = Ctx.pFile;
+	uint64_t lastClocks = Ctx.StartClocks;
+
+	if (pFile == NULL)
+		return false;
+	Ctx.pFile = NULL;
+
+	writeHeader(pFile);
+	fprintf(pFile, "#0\n$dumpvars\n");
+	for (uint8_t port = 0; port < HOST_NUM_PORTS; port++) {
+		for (uint8_t pin = 0; pin < PINS_PER_PORT; pin++) {
+			if (Ctx.UsedPins[port] & (1 << pin))
+				fprintf(pFile, "%d%c\n", (Ctx.StartPins[port] >> pin) & 1,
+						FIRST_ID + port * PINS_PER_PORT + pin);
+		}
+	}
+	for (uint8_t mark = 0; mark < Ctx.NumMarks; mark++) {
+		fprintf(pFile, "0%c\n", FIRST_ID + FIRST_MARK + mark);
+	}
+	fprintf(pFile, "$end\n");
+
+	for (uint32_t i = 0; i < Ctx.NumChanges; i++) {
+		HostWaveChange_t *pChange = &Ctx.pChanges[i];
+		if (pChange->Clocks != lastClocks) {
+			fprintf(pFile, "#%llu\n", (unsigned long long)
+					((pChange->Clocks - Ctx.StartClocks) * NS_PER_CLOCK));
+			lastClocks = pChange->Clocks;
+		}
+		fprintf(pFile, "%d%c\n", pChange->Level, FIRST_ID + pChange->Signal);
+	}
+
+	free(Ctx.pChanges);
+	Ctx.pChanges = NULL;
+	return (fclose(pFile) == 0);
+}
+
+/****************************************************************************
+ Function
+     HostWave_Compare
+
+ Parameters
+     const char * : the capture to compare against
+		 const char * : the new capture
+		 uint8_t : how much slower (%) an operation may get
+
+ Returns
+     int : operations that got too slow, -1 if a file cannot be read
+
+ Description
+     prints the average time of every mark in both files and the change,
+		 flagging the ones over the tolerance
+ Notes
+
+****************************************************************************/
+int HostWave_Compare(const char *pBaseName, const char *pNewName,
+		uint8_t TolerancePercent) {
+	MarkTime_t base[HOST_WAVE_MAX_MARKS];
+	MarkTime_t new[HOST_WAVE_MAX_MARKS];
+	int numBase = measureFile(pBaseName, base);
+	int numNew = measureFile(pNewName, new);
+	int slower = 0;
+
+	if ((numBase < 0) || (numNew < 0))
+		return -1;
+
+	printf("%-24s %12s %12s %8s\n", "operation", "base (us)", "new (us)", "change");
+	for (int i = 0; i < numBase; i++) {
+		int j;
+		if (base[i].Count == 0)
+			continue;
+		for (j = 0; j < numNew; j++) {
+			if ((strcmp(base[i].Name, new[j].Name) == 0) && (new[j].Count > 0))
+				break;
+		}
+		if (j == numNew) {
+			printf("%-24s %12.1f %12s %8s  MISSING\n", base[i].Name,
+					averageUs(&base[i]), "-", "-");
+			slower++;
+			continue;
+		}
+
+		double was = averageUs(&base[i]);
+		double now = averageUs(&new[j]);
+		double change = (was > 0) ? 100.0 * (now - was) / was : 0.0;
+		bool tooSlow = (now * 100.0 > was * (100.0 + TolerancePercent));
+		printf("%-24s %12.1f %12.1f %+7.1f%%%s\n", base[i].Name, was, now,
+				change, tooSlow ? "  SLOWER" : "");
+		if (tooSlow)
+			slower++;
+	}
+	return slower;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+// keeps one change at the present clock, growing the store as needed
+static void addChange(uint8_t Signal, bool Level) {
+	if (Ctx.NumChanges == Ctx.Size) {
+		HostWaveChange_t *pBigger = realloc(Ctx.pChanges,
+				2 * Ctx.Size * sizeof(HostWaveChange_t));
+		if (pBigger == NULL)
+			return;
+		Ctx.pChanges = pBigger;
+		Ctx.Size *= 2;
+	}
+	Ctx.pChanges[Ctx.NumChanges].Clocks = HostSim_GetClocks();
+	Ctx.pChanges[Ctx.NumChanges].Signal = Signal;
+	Ctx.pChanges[Ctx.NumChanges].Level = Level;
+	Ctx.NumChanges++;
+}
+
+// declares a wire for every pin that moved and for every mark
+static void writeHeader(FILE *pFile) {
+	fprintf(pFile, "$version host build $end\n");
+	fprintf(pFile, "$timescale 1 ns $end\n");
+	fprintf(pFile, "$scope module tiva $end\n");
+	for (uint8_t port = 0; port < HOST_NUM_PORTS; port++) {
+		if (Ctx.UsedPins[port] == 0)
+			continue;
+		fprintf(pFile, "$scope module PORT%c $end\n", 'A' + port);
+		for (uint8_t pin = 0; pin < PINS_PER_PORT; pin++) {
+			if (Ctx.UsedPins[port] & (1 << pin))
+				fprintf(pFile, "$var wire 1 %c P%c%d $end\n",
+						FIRST_ID + port * PINS_PER_PORT + pin, 'A' + port, pin);
+		}
+		fprintf(pFile, "$upscope $end\n");
+	}
+	fprintf(pFile, "$upscope $end\n");
+
+	fprintf(pFile, "$scope module " MARKS_SCOPE " $end\n");
+	for (uint8_t mark = 0; mark < Ctx.NumMarks; mark++) {
+		fprintf(pFile, "$var wire 1 %c %s $end\n", FIRST_ID + FIRST_MARK + mark,
+				Ctx.MarkNames[mark]);
+	}
+	fprintf(pFile, "$upscope $end\n");
+	fprintf(pFile, "$enddefinitions $end\n");
+}
+
+// reads the marks of a VCD file and how long they were HI, returns how
+// many marks there are or -1 if the file cannot be read
+static int measureFile(const char *pName, MarkTime_t *pMarks) {
+	FILE *pFile = fopen(pName, "r");
+	char token[TOKEN_SIZE];
+	char scope[TOKEN_SIZE] = "";
+	double nsPerUnit = 1.0;
+	double now = 0.0;
+	int numMarks = 0;
+
+	if (pFile == NULL) {
+		printf("HostWave: cannot read %s\n", pName);
+		return -1;
+	}
+
+	while (fscanf(pFile, "%63s", token) == 1) {
+		if (strcmp(token, "$timescale") == 0) {
+			nsPerUnit = timescaleNs(pFile);
+		} else if (strcmp(token, "$scope") == 0) {
+			if (fscanf(pFile, "%*s %63s", scope) != 1)
+				break;
+			skipToEnd(pFile);
+		} else if (strcmp(token, "$upscope") == 0) {
+			scope[0] = '\0';
+			skipToEnd(pFile);
+		} else if (strcmp(token, "$var") == 0) {
+			char id[TOKEN_SIZE], name[TOKEN_SIZE];
+			int width;
+			if (fscanf(pFile, "%*s %d %63s %63s", &width, id, name) != 3)
+				break;
+			skipToEnd(pFile);
+			if ((strcmp(scope, MARKS_SCOPE) == 0) && (width == 1)
+					&& (numMarks < HOST_WAVE_MAX_MARKS)) {
+				MarkTime_t *pMark = &pMarks[numMarks++];
+				memset(pMark, 0, sizeof(MarkTime_t));
+				strcpy(pMark->Name, name);
+				strcpy(pMark->Id, id);
+			}
+		} else if ((strcmp(token, "$dumpvars") == 0) || (strcmp(token, "$end") == 0)) {
+			// the values inside $dumpvars are read like any others
+		} else if (token[0] == '$') {
+			skipToEnd(pFile);
+		} else if (token[0] == '#') {
+			now = strtod(&token[1], NULL) * nsPerUnit;
+		} else if ((token[0] == 'b') || (token[0] == 'B') || (token[0] == 'r')
+				|| (token[0] == 'R')) {
+			// vector or real value, its identifier follows
+			if (fscanf(pFile, "%*s") != 0)
+				break;
+		} else {
+			bool level = (token[0] == '1');
+			for (int i = 0; i < numMarks; i++) {
+				MarkTime_t *pMark = &pMarks[i];
+				if (strcmp(pMark->Id, &token[1]) != 0)
+					continue;
+				if (level && !pMark->High) {
+					pMark->RoseAt = now;
+					pMark->Count++;
+				} else if (!level && pMark->High) {
+					pMark->HighNs += now - pMark->RoseAt;
+				}
+				pMark->High = level;
+			}
+		}
+	}
+	fclose(pFile);
+	return numMarks;
+}
+
+// reads the rest of a $timescale, such as "1 ns $end" or "10ps $end"
+static double timescaleNs(FILE *pFile) {
+	char token[TOKEN_SIZE];
+	char unit[TOKEN_SIZE] = "";
+	double count = 1.0;
+
+	if (fscanf(pFile, "%63s", token) != 1)
+		return 1.0;
+	count = strtod(token, NULL);
+	sscanf(token, "%*[0-9]%63s", unit);
+	if ((unit[0] == '\0') && (fscanf(pFile, "%63s", unit) != 1))
+		return 1.0;
+	if (strcmp(unit, "$end") != 0)
+		skipToEnd(pFile);
+
+	if (strcmp(unit, "s") == 0)
+		return count * 1e9;
+	if (strcmp(unit, "ms") == 0)
+		return count * 1e6;
+	if (strcmp(unit, "us") == 0)
+		return count * 1e3;
+	if (strcmp(unit, "ps") == 0)
+		return count * 1e-3;
+	if (strcmp(unit, "fs") == 0)
+		return count * 1e-6;
+	return count;
+}
+
+// skips the tokens up to and including the next $end
+static void skipToEnd(FILE *pFile) {
+	char token[TOKEN_SIZE];
+
+	while (fscanf(pFile, "%63s", token) == 1) {
+		if (strcmp(token, "$end") == 0)
+			return;
+	}
+}
+
+// average time a mark was HI, in us
+static double averageUs(const MarkTime_t *pMark) {
+	return (pMark->Count == 0) ? 0.0 : pMark->HighNs / pMark->Count / 1000.0;
+}
+
+/****************************************************************************
+ Test Harness for the waveform capture
+
+ Description
+     "capture FILE" runs a fixed set of LCD and LED operations, each under a
+		 mark named after it, and writes FILE. "compare BASE NEW [PERCENT]"
+		 compares two captures and exits 1 if an operation got more than
+		 PERCENT (default 5) slower
+ Notes
+     LCDputchar is private to LCD.c, so it is declared here
+****************************************************************************/
+#ifdef TEST
+#include "LCD.h"
+#include "LEDs.h"
+
+#define DEFAULT_TOLERANCE 5
+#define NUM_CHARS 16
+#define NUM_LEDS 8
+
+void LCDputchar(char letter);
+
+// sends what LCD.c queued, a nibble per tick, the way the LCD service would
+static void drainLCD(void) {
+	ES_Event timeout = { ES_TIMEOUT, LCD_TIMER };
+
+	while (isLCDBusy()) {
+		HostSim_SkipTicks(1);
+		HostWave_Mark("sendNibbleToLCD", true);
+		RunLCDService(timeout);
+		HostWave_Mark("sendNibbleToLCD", false);
+	}
+}
+
+static void capture(const char *pFileName) {
+	MarkTime_t marks[HOST_WAVE_MAX_MARKS];
+
+	if (!HostWave_Open(pFileName)) {
+		printf("cannot write %s\n", pFileName);
+		exit(2);
+	}
+
+	HostWave_Mark("LCDInit", true);
+	LCDInit();
+	HostWave_Mark("LCDInit", false);
+
+	for (int i = 0; i < 4; i++) {
+		HostWave_Mark("clearLCD", true);
+		clearLCD();
+		HostWave_Mark("clearLCD", false);
+		drainLCD();
+	}
+	for (int i = 0; i < NUM_CHARS; i++) {
+		HostWave_Mark("LCDputchar", true);
+		LCDputchar('A' + i);
+		HostWave_Mark("LCDputchar", false);
+		drainLCD();
+	}
+	for (int i = 0; i < 2; i++) {
+		HostWave_Mark("printArmedMessage", true);
+		printArmedMessage();
+		HostWave_Mark("printArmedMessage", false);
+		drainLCD();
+	}
+
+	LEDShiftRegInit();
+	for (int i = 0; i < NUM_LEDS; i++) {
+		setLEDs(1 << i);
+		HostWave_Mark("flushLEDs", true);
+		flushLEDs();
+		HostWave_Mark("flushLEDs", false);
+	}
+
+	// one BAM plane per call; the host has no timer interrupt to call it
+	const uint8_t levels[NUM_LEDS] = {0, 1, 3, 5, 7, 9, 11, 15};
+	setLEDLevels(0, 0xFF, levels);
+	for (int i = 0; i < 2 * LED_LEVEL_BITS; i++) {
+		HostWave_Mark("LEDRefreshISR", true);
+		LEDRefreshISR();
+		HostWave_Mark("LEDRefreshISR", false);
+	}
+	setLEDLevels(0, 0, NULL);
+
+	if (!HostWave_Close()) {
+		printf("cannot write %s\n", pFileName);
+		exit(2);
+	}
+
+	int numMarks = measureFile(pFileName, marks);
+	printf("%s written\n%-24s %8s %12s\n", pFileName, "operation", "count", "each (us)");
+	for (int i = 0; i < numMarks; i++) {
+		printf("%-24s %8u %12.1f\n", marks[i].Name, (unsigned)marks[i].Count,
+				averageUs(&marks[i]));
+	}
+}
+
+int main(int argc, char *argv[]) {
+	puts("\n\r In Test Harness for the waveform capture\r");
+
+	if ((argc == 3) && (strcmp(argv[1], "capture") == 0)) {
+		capture(argv[2]);
+		return 0;
+	}
+	if (((argc == 4) || (argc == 5)) && (strcmp(argv[1], "compare") == 0)) {
+		int tolerance = (argc == 5) ? atoi(argv[4]) : DEFAULT_TOLERANCE;
+		int slower = HostWave_Compare(argv[2], argv[3], (uint8_t)tolerance);
+		if (slower < 0)
+			return 2;
+		printf("%d operation(s) more than %d%% slower\n", slower, tolerance);
+		return (slower > 0) ? 1 : 0;
+	}
+
+	printf("usage: %s capture FILE\n"
+			"       %s compare BASE NEW [PERCENT]\n", argv[0], argv[0]);
+	return 2;
+}
+#endif
@@ -0,0 +1,66 @@
+/****************************************************************************
+
+  Header file for HostWave.c -- pin waveforms of the host build as VCD
+
+ ****************************************************************************/
+
+#ifndef HOST_WAVE_H
+#define HOST_WAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* NOTES:
+
+	While a capture is open, every change of a GPIO pin level (outputs as
+	the firmware writes them, inputs as HostHAL_SetInput drives them) is
+	kept with the simulated clock it happened on. HostWave_Close writes them
+	out as a VCD file that GTKWave or any logic analyser viewer opens, one
+	wire per pin that moved (PC5 is the LCD SCK, PA3 the LED SCK, and so on).
+	A pin turned from input to output shows its new level at the next write
+	to its port.
+
+	Marks are extra wires, named by the caller and held HI around a piece
+	of work: HostWave_Mark("flushLEDs", true); flushLEDs();
+	HostWave_Mark("flushLEDs", false). They end up in their own "marks" scope.
+
+	HostWave_Compare reads two captures back, and for each mark in both
+	works out the average time it was HI, that is the bus time of one
+	operation. An operation that got slower by more than the tolerance
+	counts as a regression, so a script can fail on the return value.
+	Anything with 1-bit wires in a scope called "marks" can be compared,
+	whatever made the file.
+
+	The TEST harness is the tool: "capture FILE" runs a set of LCD and LED
+	operations under marks and writes FILE; "compare BASE NEW [PERCENT]"
+	prints the table and exits 1 if anything got slower.
+
+	Times in the file are in ns of the simulated 40MHz clock.
+*/
+
+// most marks in one capture
+#define HOST_WAVE_MAX_MARKS 16
+// longest mark name, including the terminator
+#define HOST_WAVE_NAME_SIZE 32
+
+// Public Function Prototypes
+
+// starts capturing the running station's pins, to be written to pFileName
+bool HostWave_Open(const char *pFileName);
+
+// raises (true) or lowers (false) the mark called pName
+void HostWave_Mark(const char *pName, bool Active);
+
+// called by HostHAL.c with a port's pin levels whenever they may have changed
+void HostWave_Pins(uint8_t Port, uint8_t Levels);
+
+// writes the capture out and stops capturing; false if it could not be written
+bool HostWave_Close(void);
+
+// compares the marks of two captures, returns how many got slower than
+// TolerancePercent allows (a mark missing from pNew counts), -1 if a file
+// cannot be read
+int HostWave_Compare(const char *pBaseName, const char *pNewName,
+		uint8_t TolerancePercent);
+
+#endif /* HOST_WAVE_H */
@@ -0,0 +1,34 @@
+/****************************************************************************
+
+  Host replacement for TivaWare's inc/hw_types.h
+
+  Only used by the host simulation build (see host/HostHAL.h). It is found
+  before the TivaWare copy because host/ is first on the include path, and
+  turns every HWREG access into an access to the simulated register file.
+
+ ****************************************************************************/
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// pointer to the simulated 32 bit register at address x
+volatile uint32_t *HostHAL_Reg(uint32_t Address);
+
+// register access macros, same shape as the TivaWare versions
+#define HWREG(x)  (*HostHAL_Reg((uint32_t)(x)))
+#define HWREGH(x) (*((volatile uint16_t *)HostHAL_Reg((uint32_t)(x))))
+#define HWREGB(x) (*((volatile uint8_t *)HostHAL_Reg((uint32_t)(x))))
+
+// the device class checks in driverlib are always answered as a TM4C123
+#define CLASS_IS_TM4C123 1
+#define CLASS_IS_TM4C129 0
+#define REVISION_IS_A0 0
+#define REVISION_IS_A1 0
+#define REVISION_IS_A2 0
+#define REVISION_IS_B0 0
+#define REVISION_IS_B1 0
+
+#endif // __HW_TYPES_H__
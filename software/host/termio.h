@@ -0,0 +1,25 @@
+/****************************************************************************
+
+  Host replacement for termio.h
+
+  Console I/O for the host simulation build. Keystrokes come from stdin,
+  which is put into non-blocking, unbuffered mode by TERMIO_Init.
+
+ ****************************************************************************/
+
+#ifndef TERMIO_H
+#define TERMIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// sets up stdin so keystrokes can be polled without blocking
+void TERMIO_Init(void);
+
+// returns true if a keystroke is waiting
+bool IsNewKeyReady(void);
+
+// returns the waiting keystroke
+char GetNewKey(void);
+
+#endif /* TERMIO_H */
@@ -12,6 +12,7 @@
 #include "ES_Framework.h"
 #include "ES_Port.h"
 #include "termio.h"
+#include "GameContext.h"
 
 #define clrScrn() 	printf("\x1b[2J")
 #define goHome()	printf("\x1b[1,1H")
@@ -40,6 +41,9 @@ int main(void)
 
 	// Your hardware initialization function calls go here
 
+	// power on values for the one station on this board
+	GameContext_Init(pGame);
+
 	// now initialize the Events and Services Framework and start it running
 	ErrorType = ES_Initialize(ES_Timer_RATE_1mS);
 	if ( ErrorType == Success ) {
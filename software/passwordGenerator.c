@@ -7,46 +7,59 @@
    This is a class to generate and store four random passwords of length 5 numeric digits.
 	Usage:
 	Call randomizePasswords(void) to generate the four random passwords.
-	Call checkPassword(uint8_t *guess) to check if the guess matches the correct password.
-	Call getPassword(1), getPassword(2), getPassword(3), getPassword(4) to get pointers to the
-		four password arrays.
+	Call checkPassword(uint32_t guess) to check if the guess matches the correct password.
+	Call getPassword(1), getPassword(2), getPassword(3), getPassword(4) to get the
+		four passwords.
+	Call advancePassword, matchPasswords and checkPasswordState to follow digits as
+		they are typed (see passwordGenerator.h).
+	Call addEntropy(sample) with every ADC sample taken, to feed the generator.
 ****************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include "passwordGenerator.h"
-#include "ADCSWTrigger.h"
+#include "GameContext.h"
+
+// a transition that has not been filled in yet
+#define NO_STATE 0xFF
+
+// words in the generator state and in the entropy pool
+#define RANDOM_WORDS 4
+// rotates a uint32_t left by k, 0 < k < 32
+#define ROTL(x, k) (((x) << (k)) | ((x) >> (32 - (k))))
+// odd constant (2^32 over the golden ratio) that spreads a sample over a word
+#define SPREAD 0x9E3779B9u
 
-// Maximum password length
-#define MAX_PASS_LENGTH 5
-// Number of passwords to store
-#define NUM_PASSWORDS 4
+// The correct password index and the passwords themselves are kept in
+// PasswordContext_t (see GameContext.h)
+#define Ctx (pGame->Passwords)
 
-// Variable to store the correct password index
-static uint8_t correctPassword = 0;
-// Variables to store the passwords
-static uint8_t password1[MAX_PASS_LENGTH];
-static uint8_t password2[MAX_PASS_LENGTH];
-static uint8_t password3[MAX_PASS_LENGTH];
-static uint8_t password4[MAX_PASS_LENGTH];
+// Private functions
+static uint32_t nextRandom(void);
+static uint32_t randomBelow(uint32_t limit);
+static void seedRandom(void);
+static void buildMatcher(void);
+static bool samePassword(uint32_t password1, uint32_t password2);
 
 /****************************************************************************
  Function
      generateRandomPassword
  Parameters
-     uint8_t* randomPassword : a pointer to the password array
- Returns
      void
+ Returns
+     uint32_t : the packed password
  Description
-     Generates a random password and stores it in the array
+     Generates a random password
  Notes
 ****************************************************************************/
-void generateRandomPassword(uint8_t* randomPassword) {
-	// gets MAX_PASS_LENGTH (5) random numbers  
+uint32_t generateRandomPassword(void) {
+	uint32_t randomPassword = 0;
+	// gets MAX_PASS_LENGTH (5) random numbers, the first one ending up on top
 	for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
-		randomPassword[i] = rand() % 10;
+		randomPassword = (randomPassword << 4) | randomBelow(10);
 	}
+	return randomPassword;
 }
 
 /****************************************************************************
@@ -62,13 +75,15 @@ void generateRandomPassword(uint8_t* randomPassword) {
  Notes
 ****************************************************************************/
 void randomizePasswords(void) {
-	srand(ADC0_InSeq3());
-	generateRandomPassword(password1);
-	generateRandomPassword(password2);
-	generateRandomPassword(password3);
-	generateRandomPassword(password4);
+	// each station keeps its own generator, stirred with the ADC noise
+	// collected since the last time
+	seedRandom();
+	for (uint8_t i = 0; i < NUM_PASSWORDS; i++) {
+		Ctx.passwords[i] = generateRandomPassword();
+	}
 	// randomly selects which of the passwords is the correct one
-	correctPassword = rand() % NUM_PASSWORDS + 1;
+	Ctx.correctPassword = randomBelow(NUM_PASSWORDS) + 1;
+	buildMatcher();
 }
 
 /****************************************************************************
@@ -77,137 +92,363 @@ void randomizePasswords(void) {
  Parameters
      uint8_t num : password index
  Returns
-     uint8_t* : pointer to the password array at the specified index
+     uint32_t : the packed password at the specified index
  Description
-     Returns a pointer to the password array at the specified index
+     Returns the packed password at the specified index
  Notes
+     0 (00000) for an index that is not 1 to NUM_PASSWORDS
 ****************************************************************************/
-uint8_t* getPassword(uint8_t num) {
-	switch (num) {
-		case 1:
-			return password1;
-		case 2:
-			return password2;
-		case 3:
-			return password3;
-		case 4:
-			return password4;
+uint32_t getPassword(uint8_t num) {
+	if ((num < 1) || (num > NUM_PASSWORDS))
+		return 0;
+	return Ctx.passwords[num - 1];
+}
+
+/****************************************************************************
+ Function
+     packPassword
+ Parameters
+     const uint8_t *pDigits : MAX_PASS_LENGTH digits, each 0 to 9
+ Returns
+     uint32_t : the packed password
+ Description
+     Packs digits kept one a byte into a password
+ Notes
+     only the low nibble of each digit is kept
+****************************************************************************/
+uint32_t packPassword(const uint8_t *pDigits) {
+	uint32_t password = 0;
+	for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
+		password = (password << 4) | (pDigits[i] & 0xF);
 	}
-	return NULL;
+	return password;
 }
 
 /****************************************************************************
  Function
-     printPassword
+     unpackPassword
  Parameters
-     uint8_t* password : pointer to the password array
+     uint32_t password : the packed password
+     uint8_t *pDigits : where the MAX_PASS_LENGTH digits go
  Returns
      void
  Description
-     Prints the password to console
+     Unpacks a password into digits kept one a byte
  Notes
 ****************************************************************************/
-void printPassword(uint8_t* password) {
+void unpackPassword(uint32_t password, uint8_t *pDigits) {
 	for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
-		printf("%d ", password[i]);
+		pDigits[i] = PASSWORD_DIGIT(password, i);
 	}
-	printf("\r\n");
 }
 
 /****************************************************************************
  Function
      printPassword
  Parameters
-     uint8_t* password : pointer to the password array
+     uint32_t password : the packed password
  Returns
      void
  Description
      Prints the password to console
  Notes
 ****************************************************************************/
-// this function gets used to compare a password to a password being entered
-bool compareIntArrays(uint8_t *array1, uint8_t *array2) {
-	if (sizeof(array1) != sizeof(array2))
+void printPassword(uint32_t password) {
+	for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
+		printf("%d ", (int)PASSWORD_DIGIT(password, i));
+	}
+	printf("\r\n");
+}
+
+/****************************************************************************
+ Function
+     checkPassword
+ Parameters
+     uint32_t guess : the packed password guess
+ Returns
+     bool : true if the guess is the correct password
+ Description
+     Checks to see if the password guess corresponds to the correct password.
+ Notes
+     takes the same time whichever digits are right; false until
+     randomizePasswords has picked the correct password
+****************************************************************************/
+bool checkPassword(uint32_t guess) {
+	if (Ctx.correctPassword == 0)
 		return false;
-	else {
-		for (uint8_t i = 0; i < sizeof(array1); i++) {
-			if (array1[i] != array2[i])
-				return false;
+	return samePassword(getPassword(Ctx.correctPassword), guess);
+}
+
+/****************************************************************************
+ Function
+     advancePassword
+ Parameters
+     uint8_t State : the automaton state after the digits typed so far
+     uint8_t Digit : the digit typed next, 0 to 9
+ Returns
+     uint8_t : the state after Digit
+ Description
+     Follows one more typed digit through the automaton built by
+     randomizePasswords
+ Notes
+     anything but a digit restarts at PASSWORD_START
+****************************************************************************/
+uint8_t advancePassword(uint8_t State, uint8_t Digit) {
+	if ((State >= PASSWORD_STATES) || (Digit >= NUM_DIGITS))
+		return PASSWORD_START;
+	return Ctx.Next[State][Digit];
+}
+
+/****************************************************************************
+ Function
+     matchPasswords
+ Parameters
+     uint8_t State : the automaton state after the digits typed so far
+ Returns
+     uint8_t : bit n-1 set if the last digits typed are password n
+ Description
+     Tells which of the four passwords the digits typed so far end with
+ Notes
+     more than one bit is set only if passwords came out the same
+****************************************************************************/
+uint8_t matchPasswords(uint8_t State) {
+	if (State >= PASSWORD_STATES)
+		return 0;
+	return Ctx.Matches[State];
+}
+
+/****************************************************************************
+ Function
+     checkPasswordState
+ Parameters
+     uint8_t State : the automaton state after the digits typed so far
+ Returns
+     bool : true if the last digits typed are the correct password
+ Description
+     Checks to see if the digits typed so far end with the correct password.
+ Notes
+     false until randomizePasswords has picked the correct password
+****************************************************************************/
+bool checkPasswordState(uint8_t State) {
+	if (Ctx.correctPassword == 0)
+		return false;
+	return (matchPasswords(State) & (1 << (Ctx.correctPassword - 1))) != 0;
+}
+
+/****************************************************************************
+ Function
+     buildMatcher
+ Parameters
+     void
+ Returns
+     void
+ Description
+     Builds the automaton over the four passwords: a trie of their digits,
+     then, breadth first, each state's fallback (the longest tail of its
+     digits that is also a state) to fill in the digits the trie has no
+     branch for and to take over the passwords the fallback matches
+ Notes
+     at most PASSWORD_STATES states, the start being PASSWORD_START
+****************************************************************************/
+static void buildMatcher(void) {
+	uint8_t fallback[PASSWORD_STATES];
+	uint8_t order[PASSWORD_STATES]; // states, breadth first
+	uint8_t states = 1;
+	
+	// the trie
+	for (uint8_t s = 0; s < PASSWORD_STATES; s++) {
+		for (uint8_t d = 0; d < NUM_DIGITS; d++) {
+			Ctx.Next[s][d] = NO_STATE;
+		}
+		Ctx.Matches[s] = 0;
+	}
+	for (uint8_t p = 1; p <= NUM_PASSWORDS; p++) {
+		uint32_t password = getPassword(p);
+		uint8_t s = PASSWORD_START;
+		for (uint8_t i = 0; i < MAX_PASS_LENGTH; i++) {
+			uint8_t digit = PASSWORD_DIGIT(password, i);
+			if (Ctx.Next[s][digit] == NO_STATE)
+				Ctx.Next[s][digit] = states++;
+			s = Ctx.Next[s][digit];
+		}
+		Ctx.Matches[s] |= 1 << (p - 1);
+	}
+	
+	// the start falls back on itself
+	uint8_t head = 0, tail = 0;
+	for (uint8_t d = 0; d < NUM_DIGITS; d++) {
+		uint8_t s = Ctx.Next[PASSWORD_START][d];
+		if (s == NO_STATE) {
+			Ctx.Next[PASSWORD_START][d] = PASSWORD_START;
+		} else {
+			fallback[s] = PASSWORD_START;
+			order[tail++] = s;
+		}
+	}
+	// every other state falls back on where its fallback goes with its last
+	// digit; states closer to the start are done first, so that is known
+	while (head < tail) {
+		uint8_t s = order[head++];
+		Ctx.Matches[s] |= Ctx.Matches[fallback[s]];
+		for (uint8_t d = 0; d < NUM_DIGITS; d++) {
+			uint8_t next = Ctx.Next[s][d];
+			if (next == NO_STATE) {
+				Ctx.Next[s][d] = Ctx.Next[fallback[s]][d];
+			} else {
+				fallback[next] = Ctx.Next[fallback[s]][d];
+				order[tail++] = next;
+			}
 		}
-		return true;
 	}
 }
 
 /****************************************************************************
  Function
-     checkPassword
+     samePassword
  Parameters
-     uint8_t *guess : pointer to the password guess array
+     uint32_t password1, password2 : two packed passwords
+ Returns
+     bool : true if they are the same
+ Description
+     Compares all the digits at once, without a branch, so that how long
+     it takes does not give away how many digits are right
+ Notes
+     the difference is folded into its top bit: d | -d has it set for
+     any d but 0
+****************************************************************************/
+static bool samePassword(uint32_t password1, uint32_t password2) {
+	uint32_t difference = password1 ^ password2;
+	return (bool)(((difference | (0u - difference)) >> 31) ^ 1);
+}
+
+/****************************************************************************
+ Function
+     addEntropy
+ Parameters
+     uint16_t sample : an ADC conversion result
  Returns
      void
  Description
-     Checks to see if the password guess corresponds to the correct password.
+     Stirs a sample into the entropy pool. The sample is spread over a
+     whole word by a multiply, so the noise in its low bits reaches every
+     bit, and the pool words take turns
  Notes
+     a rotate, a multiply and an XOR, cheap enough for every sample
 ****************************************************************************/
-// the function that actually checks to make sure the password is matching
-bool checkPassword(uint8_t *guess) {
-	switch (correctPassword) {
-		case 1:
-			if (compareIntArrays(password1, guess))
-				return true;
-			break;
-		case 2:
-			if (compareIntArrays(password2, guess))
-				return true;
-			break;
-		case 3:
-			if (compareIntArrays(password3, guess))
-				return true;
-			break;
-		case 4:
-			if (compareIntArrays(password4, guess))
-				return true;
-			break;
+void addEntropy(uint16_t sample) {
+	uint8_t i = Ctx.poolIndex;
+	Ctx.pool[i] = ROTL(Ctx.pool[i], 7) ^ ((sample + 1u) * SPREAD);
+	Ctx.poolIndex = (i + 1) % RANDOM_WORDS;
+}
+
+/****************************************************************************
+ Function
+     seedRandom
+ Parameters
+     void
+ Returns
+     void
+ Description
+     Mixes the entropy pool into the generator state. The state is never
+     replaced, so what earlier games left in it still counts
+ Notes
+     does not wait for samples: whatever the pool holds is used
+****************************************************************************/
+static void seedRandom(void) {
+	uint32_t any = 0;
+	for (uint8_t i = 0; i < RANDOM_WORDS; i++) {
+		Ctx.random[i] ^= Ctx.pool[i];
+		any |= Ctx.random[i];
 	}
-	return false;
+	// the generator is stuck at all zeros, so never leave it there
+	if (any == 0)
+		Ctx.random[0] = SPREAD;
+}
+
+/****************************************************************************
+ Function
+     nextRandom
+ Parameters
+     void
+ Returns
+     uint32_t : a random number, all 32 bits
+ Description
+     xoshiro128** (Blackman and Vigna) on this station's state, so that
+     stations do not share one sequence
+ Notes
+****************************************************************************/
+static uint32_t nextRandom(void) {
+	uint32_t *s = Ctx.random;
+	uint32_t result = ROTL(s[1] * 5, 7) * 9;
+	uint32_t t = s[1] << 9;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = ROTL(s[3], 11);
+	return result;
+}
+
+/****************************************************************************
+ Function
+     randomBelow
+ Parameters
+     uint32_t limit : how many values to pick from, at least 1
+ Returns
+     uint32_t : a random number from 0 to limit - 1
+ Description
+     Every value is equally likely: numbers from the bottom of the range
+     that would make some values come up once more than others (2^32 is
+     not a multiple of limit) are thrown away and drawn again
+ Notes
+     (0 - limit) % limit is 2^32 % limit; at most limit - 1 of the 2^32
+     numbers are thrown away, so a second draw is hardly ever needed
+****************************************************************************/
+static uint32_t randomBelow(uint32_t limit) {
+	uint32_t threshold = (0u - limit) % limit;
+	uint32_t r;
+	do {
+		r = nextRandom();
+	} while (r < threshold);
+	return r % limit;
 }
 
 #ifdef TEST 
 /* Test Harness for the Random Password Generator */
 #include "termio.h" 
+#include "ADCSWTrigger.h"
 int main(void) 
 { 
 	TERMIO_Init(); 
 	printf("\n\r In test harness of passwords\r\n");
-	/* Intializes random number generator */
-  srand(rand());
-	randomizePasswords();
-	printPassword(getPassword(1));
-	printPassword(getPassword(2));
-	printPassword(getPassword(3));
-	printPassword(getPassword(4));
-	printf("\r\nThe correct password is %d\r\n\r\n", correctPassword);
-	if (checkPassword(getPassword(1)))
-		printf("Password1 is correct\r\n");
-	else
-		printf("Password1 is incorrect\r\n");
-	if (checkPassword(getPassword(2)))
-		printf("Password2 is correct\r\n");
-	else
-		printf("Password2 is incorrect\r\n");
-	if (checkPassword(getPassword(3)))
-		printf("Password3 is correct\r\n");
-	else
-		printf("Password3 is incorrect\r\n");
-	if (checkPassword(getPassword(4)))
-		printf("Password4 is correct\r\n");
+	// no guess is correct before the passwords are drawn, not even 00000
+	if (checkPassword(0))
+		printf("00000 is correct before the passwords are drawn\r\n");
 	else
-		printf("Password4 is incorrect\r\n");
+		printf("00000 is incorrect before the passwords are drawn\r\n");
+	/* Intializes random number generator from the pot's noise */
+	ADC0_InitSWTriggerSeq3(0);
+	for (uint16_t i = 0; i < 1000; i++) {
+		addEntropy(ADC0_InSeq3());
+	}
+	randomizePasswords();
+	for (uint8_t i = 1; i <= NUM_PASSWORDS; i++) {
+		printPassword(getPassword(i));
+	}
+	printf("\r\nThe correct password is %d\r\n\r\n", Ctx.correctPassword);
+	for (uint8_t i = 1; i <= NUM_PASSWORDS; i++) {
+		if (checkPassword(getPassword(i)))
+			printf("Password%d is correct\r\n", i);
+		else
+			printf("Password%d is incorrect\r\n", i);
+	}
 		
 	// Int to Character Stuff
 	char c[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
-	for (int i = 0; i < 5; i++) {
-		printf("%c\r\n", c[getPassword(1)[i]]);
+	for (int i = 0; i < MAX_PASS_LENGTH; i++) {
+		printf("%c\r\n", c[PASSWORD_DIGIT(getPassword(1), i)]);
 	}
 }
 #endif
@@ -1,6 +1,9 @@
 #ifndef PASSWORD_GENERATOR_H
 #define PASSWORD_GENERATOR_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 /****************************************************************************
  Module
    passwordGenerator.h
@@ -9,24 +12,93 @@
    This is a class to generate and store four random passwords of length 5 numeric digits.
 	Usage:
 	Call randomizePasswords(void) to generate the four random passwords.
-	Call checkPassword(uint8_t *guess) to check if the guess matches the correct password.
-	Call getPassword(1), getPassword(2), getPassword(3), getPassword(4) to get pointers to the
-		four password arrays.
+	Call checkPassword(uint32_t guess) to check if the guess matches the correct password.
+	Call getPassword(1), getPassword(2), getPassword(3), getPassword(4) to get the
+		four passwords.
+	To follow digits as they are typed, start from PASSWORD_START and call
+		advancePassword(State, digit) for each; matchPasswords(State) tells which
+		of the four passwords the last digits spell, checkPasswordState(State)
+		whether it is the correct one.
+
+ Notes
+   randomizePasswords also builds an automaton (Aho-Corasick) over the four
+	 passwords. Its state is the longest tail of the digits typed so far that
+	 starts one of the passwords, so one table lookup per digit keeps it up to
+	 date and no digits need to be kept. A typed value that is not a digit
+	 (such as the '*' key) should restart it at PASSWORD_START.
+
+	 A password is kept packed in a uint32_t, one BCD digit per nibble, the
+	 first digit in the highest nibble used: 1 2 3 4 5 is 0x12345. So it
+	 prints as itself in hex, and two passwords compare in one go.
+	 packPassword and unpackPassword convert from and to one digit a byte,
+	 PASSWORD_DIGIT takes a single digit out.
+
+	 The digits come from a xoshiro128** generator, drawn without the bias
+	 of % 10. Every ADC sample should go through addEntropy, which stirs it
+	 into a pool of 128 bits (getPotValue does, so the event checkers top
+	 the pool up on every pass); randomizePasswords mixes the pool into the
+	 generator first, without waiting for anything.
 ****************************************************************************/
 
-// Generates a random password and stores it in the array
-void generateRandomPassword(uint8_t* randomPassword);
+// Maximum password length
+#ifndef MAX_PASS_LENGTH
+#define MAX_PASS_LENGTH 5
+#endif
+
+// Number of passwords to store
+#ifndef NUM_PASSWORDS
+#define NUM_PASSWORDS 4
+#endif
+
+#if (MAX_PASS_LENGTH < 1) || (MAX_PASS_LENGTH > 8)
+#error "a password is 1 to 8 BCD digits in a uint32_t"
+#endif
+#if (NUM_PASSWORDS < 1) || (NUM_PASSWORDS > 8)
+#error "matchPasswords has a bit for each of up to 8 passwords"
+#endif
+
+// digit i (0 is the first) of a packed password
+#define PASSWORD_DIGIT(Password, i) (((Password) >> (4*(MAX_PASS_LENGTH-1-(i)))) & 0xF)
+
+// digits a password is made of
+#define NUM_DIGITS 10
+
+// states of the password automaton: the start and one per digit of each password
+#define PASSWORD_STATES (NUM_PASSWORDS*MAX_PASS_LENGTH + 1)
+// state before any digit has been typed
+#define PASSWORD_START 0
+
+// Returns a random packed password
+uint32_t generateRandomPassword(void);
 
 // Randomly generates four passwords and assigns one of the four passwords to be the correct password
 void randomizePasswords(void);
 
-// Returns a pointer to the password array at the specified index
-uint8_t* getPassword(uint8_t num);
+// Returns the packed password at the specified index, 1 to NUM_PASSWORDS
+uint32_t getPassword(uint8_t num);
+
+// Packs MAX_PASS_LENGTH digits, one a byte, into a password
+uint32_t packPassword(const uint8_t *pDigits);
+
+// Unpacks a password into MAX_PASS_LENGTH digits, one a byte
+void unpackPassword(uint32_t password, uint8_t *pDigits);
 
 // Prints the password to console
-void printPassword(uint8_t* password);
+void printPassword(uint32_t password);
+
+// Stirs an ADC sample into the entropy pool
+void addEntropy(uint16_t sample);
 
 // Checks to see if the password guess corresponds to the correct password.
-bool checkPassword(uint8_t *guess);
+bool checkPassword(uint32_t guess);
+
+// Returns the automaton state after one more digit (0 to 9) is typed
+uint8_t advancePassword(uint8_t State, uint8_t Digit);
+
+// Returns which passwords the digits typed up to State end with, bit 0 for password 1
+uint8_t matchPasswords(uint8_t State);
+
+// Checks to see if the digits typed up to State end with the correct password.
+bool checkPasswordState(uint8_t State);
 
 #endif